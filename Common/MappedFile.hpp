@@ -0,0 +1,189 @@
+#ifndef DEF_MAPPEDFILE_HPP
+#define DEF_MAPPEDFILE_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+/*
+	A read-only memory mapping of a whole file. The mapping is released
+	when the object is destroyed. Empty files are allowed, in which case
+	GetData() returns nullptr.
+*/
+class MappedFile {
+public:
+	enum class AccessHint {
+		Normal,
+		Sequential,
+		Random
+	};
+
+	MappedFile() {}
+
+	explicit MappedFile(const string &path) {
+		this->Open(path);
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&other) {
+		this->MoveFrom(other);
+	}
+
+	MappedFile &operator=(MappedFile &&other) {
+		if (this != &other) {
+			this->Close();
+			this->MoveFrom(other);
+		}
+		return *this;
+	}
+
+	~MappedFile() {
+		this->Close();
+	}
+
+	void Open(const string &path) {
+		this->Close();
+#ifdef _WIN32
+		this->fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (this->fileHandle == INVALID_HANDLE_VALUE)throw runtime_error{ "cannot open " + path };
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(this->fileHandle, &fileSize)) {
+			this->Close();
+			throw runtime_error{ "cannot get the size of " + path };
+		}
+		this->size = (size_t)fileSize.QuadPart;
+		if (this->size == 0)return;
+		this->mappingHandle = CreateFileMappingA(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (this->mappingHandle == nullptr) {
+			this->Close();
+			throw runtime_error{ "cannot map " + path };
+		}
+		this->data = (const uint8_t *)MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (this->data == nullptr) {
+			this->Close();
+			throw runtime_error{ "cannot map " + path };
+		}
+#else
+		this->fileDescriptor = open(path.c_str(), O_RDONLY);
+		if (this->fileDescriptor < 0)throw runtime_error{ "cannot open " + path };
+		struct stat fileStatus;
+		if (fstat(this->fileDescriptor, &fileStatus) != 0) {
+			this->Close();
+			throw runtime_error{ "cannot get the size of " + path };
+		}
+		this->size = (size_t)fileStatus.st_size;
+		if (this->size == 0)return;
+		void *address = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, this->fileDescriptor, 0);
+		if (address == MAP_FAILED) {
+			this->Close();
+			throw runtime_error{ "cannot map " + path };
+		}
+		this->data = (const uint8_t *)address;
+#endif
+	}
+
+	void Close() {
+#ifdef _WIN32
+		if (this->data != nullptr)UnmapViewOfFile(this->data);
+		if (this->mappingHandle != nullptr)CloseHandle(this->mappingHandle);
+		if (this->fileHandle != INVALID_HANDLE_VALUE)CloseHandle(this->fileHandle);
+		this->mappingHandle = nullptr;
+		this->fileHandle = INVALID_HANDLE_VALUE;
+#else
+		if (this->data != nullptr)munmap((void *)this->data, this->size);
+		if (this->fileDescriptor >= 0)close(this->fileDescriptor);
+		this->fileDescriptor = -1;
+#endif
+		this->data = nullptr;
+		this->size = 0;
+	}
+
+	// tells the operating system how the mapping is going to be read,
+	// this is only a hint and does nothing on some platforms
+	void Advise(AccessHint hint) const {
+#ifndef _WIN32
+		if (this->data == nullptr)return;
+		int advice = MADV_NORMAL;
+		if (hint == AccessHint::Sequential)advice = MADV_SEQUENTIAL;
+		if (hint == AccessHint::Random)advice = MADV_RANDOM;
+		madvise((void *)this->data, this->size, advice);
+#else
+		(void)hint;
+#endif
+	}
+
+	// asks the operating system to read the pages covering [offset, offset + length)
+	// ahead of time, so that the following accesses do not stall one by one
+	void Prefetch(size_t offset, size_t length) const {
+#ifndef _WIN32
+		if (this->data == nullptr || offset >= this->size)return;
+		auto pageSize = GetPageSize();
+		auto alignedOffset = offset / pageSize * pageSize;
+		auto alignedLength = min(offset + length, this->size) - alignedOffset;
+		madvise((void *)(this->data + alignedOffset), alignedLength, MADV_WILLNEED);
+#else
+		(void)offset;
+		(void)length;
+#endif
+	}
+
+	const uint8_t *GetData() const { return this->data; }
+	size_t GetSize() const { return this->size; }
+
+	static size_t GetPageSize() {
+#ifdef _WIN32
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		return (size_t)systemInfo.dwPageSize;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+private:
+	void MoveFrom(MappedFile &other) {
+		this->data = other.data;
+		this->size = other.size;
+		other.data = nullptr;
+		other.size = 0;
+#ifdef _WIN32
+		this->fileHandle = other.fileHandle;
+		this->mappingHandle = other.mappingHandle;
+		other.fileHandle = INVALID_HANDLE_VALUE;
+		other.mappingHandle = nullptr;
+#else
+		this->fileDescriptor = other.fileDescriptor;
+		other.fileDescriptor = -1;
+#endif
+	}
+
+	const uint8_t *data{ nullptr };
+	size_t size{ 0 };
+#ifdef _WIN32
+	HANDLE fileHandle{ INVALID_HANDLE_VALUE };
+	HANDLE mappingHandle{ nullptr };
+#else
+	int fileDescriptor{ -1 };
+#endif
+};
+
+#endif
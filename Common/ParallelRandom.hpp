@@ -0,0 +1,466 @@
+#ifndef DEF_PARALLELRANDOM_HPP
+#define DEF_PARALLELRANDOM_HPP
+
+#include <array>
+#include <limits>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARALLELRANDOM_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARALLELRANDOM_USE_SSE2
+#endif
+
+using namespace std;
+
+/*
+	The random number generation shared by the randomized components:
+	- Xoshiro256StarStar, the xoshiro256** generator of Blackman and Vigna,
+	  which is fast, has a period of 2^256 - 1, and can jump ahead 2^128
+	  numbers, so that stream i of a seed never overlaps stream j;
+	- BlockRandomEngine, several xoshiro256** lanes stepped together to fill
+	  blocks of numbers with SIMD instructions;
+	- BoundedUniformIntDistribution and FillBounded(), uniform integers in a
+	  range by Lemire's multiply-and-shift method, which only divides when a
+	  value has to be rejected, with probability range / 2^64.
+	Both engines model the standard UniformRandomBitGenerator, and the
+	distribution takes the same parameters as uniform_int_distribution, so
+	they can stand in for the standard ones. Given the same seed, every
+	platform produces the same numbers.
+*/
+
+namespace RandomDetail {
+	inline uint64_t RotateLeft(uint64_t value, int shift) {
+		return (value << shift) | (value >> (64 - shift));
+	}
+
+	// splitmix64, spreads a 64-bit seed over the state of a generator
+	inline uint64_t SplitMix64(uint64_t &state) {
+		auto value = (state += 0x9e3779b97f4a7c15ULL);
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+		return value ^ (value >> 31);
+	}
+
+	// the high 64 bits of the 128-bit product, and the low ones in low
+	inline uint64_t MultiplyHigh(uint64_t left, uint64_t right, uint64_t &low) {
+#ifdef __SIZEOF_INT128__
+		auto product = (unsigned __int128)left * right;
+		low = (uint64_t)product;
+		return (uint64_t)(product >> 64);
+#else
+		auto leftLow = left & 0xffffffffULL, leftHigh = left >> 32;
+		auto rightLow = right & 0xffffffffULL, rightHigh = right >> 32;
+		auto lowLow = leftLow * rightLow;
+		auto highLow = leftHigh * rightLow;
+		auto lowHigh = leftLow * rightHigh;
+		auto middle = (lowLow >> 32) + (highLow & 0xffffffffULL) + (lowHigh & 0xffffffffULL);
+		low = (middle << 32) | (lowLow & 0xffffffffULL);
+		return leftHigh * rightHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+#endif
+	}
+
+	// whether the engine returns uniform 64-bit words
+	template<typename Engine>
+	struct IsFullWordEngine : integral_constant<bool, Engine::min() == 0
+		&& Engine::max() == numeric_limits<uint64_t>::max()> {};
+
+	template<typename Engine>
+	uint64_t GetWord(Engine &engine, true_type) {
+		return (uint64_t)engine();
+	}
+
+	template<typename Engine>
+	uint64_t GetWord(Engine &engine, false_type) {
+		return uniform_int_distribution<uint64_t>{}(engine);
+	}
+
+	// a uniform 64-bit word from any engine
+	template<typename Engine>
+	uint64_t GetWord(Engine &engine) {
+		return GetWord(engine, IsFullWordEngine<Engine>{});
+	}
+
+	/*
+		Lemire's method: the high word of word * range is uniform in
+		[0, range) unless the low word falls below 2^64 mod range, in which
+		case the word is drawn again. The modulo is only computed then.
+	*/
+	template<typename Engine>
+	uint64_t MapBelow(Engine &engine, uint64_t word, uint64_t range) {
+		uint64_t low;
+		auto high = MultiplyHigh(word, range, low);
+		if (low < range) {
+			auto threshold = (0 - range) % range;
+			while (low < threshold)high = MultiplyHigh(GetWord(engine), range, low);
+		}
+		return high;
+	}
+
+	/*
+		The operations a step of xoshiro256** needs on a vector of lanes.
+		Without SIMD a vector is a single lane, and with it the
+		multiplications by 5 and 9 become shifts and adds.
+	*/
+#if defined(PARALLELRANDOM_USE_AVX2)
+	using LaneVector = __m256i;
+	inline LaneVector LoadLanes(const uint64_t *lanes) { return _mm256_loadu_si256((const __m256i *)lanes); }
+	inline void StoreLanes(uint64_t *lanes, LaneVector value) { _mm256_storeu_si256((__m256i *)lanes, value); }
+	inline LaneVector AddLanes(LaneVector left, LaneVector right) { return _mm256_add_epi64(left, right); }
+	inline LaneVector XorLanes(LaneVector left, LaneVector right) { return _mm256_xor_si256(left, right); }
+	inline LaneVector OrLanes(LaneVector left, LaneVector right) { return _mm256_or_si256(left, right); }
+	template<int shift> LaneVector ShiftLanesLeft(LaneVector value) { return _mm256_slli_epi64(value, shift); }
+	template<int shift> LaneVector ShiftLanesRight(LaneVector value) { return _mm256_srli_epi64(value, shift); }
+#elif defined(PARALLELRANDOM_USE_SSE2)
+	using LaneVector = __m128i;
+	inline LaneVector LoadLanes(const uint64_t *lanes) { return _mm_loadu_si128((const __m128i *)lanes); }
+	inline void StoreLanes(uint64_t *lanes, LaneVector value) { _mm_storeu_si128((__m128i *)lanes, value); }
+	inline LaneVector AddLanes(LaneVector left, LaneVector right) { return _mm_add_epi64(left, right); }
+	inline LaneVector XorLanes(LaneVector left, LaneVector right) { return _mm_xor_si128(left, right); }
+	inline LaneVector OrLanes(LaneVector left, LaneVector right) { return _mm_or_si128(left, right); }
+	template<int shift> LaneVector ShiftLanesLeft(LaneVector value) { return _mm_slli_epi64(value, shift); }
+	template<int shift> LaneVector ShiftLanesRight(LaneVector value) { return _mm_srli_epi64(value, shift); }
+#else
+	using LaneVector = uint64_t;
+	inline LaneVector LoadLanes(const uint64_t *lanes) { return *lanes; }
+	inline void StoreLanes(uint64_t *lanes, LaneVector value) { *lanes = value; }
+	inline LaneVector AddLanes(LaneVector left, LaneVector right) { return left + right; }
+	inline LaneVector XorLanes(LaneVector left, LaneVector right) { return left ^ right; }
+	inline LaneVector OrLanes(LaneVector left, LaneVector right) { return left | right; }
+	template<int shift> LaneVector ShiftLanesLeft(LaneVector value) { return value << shift; }
+	template<int shift> LaneVector ShiftLanesRight(LaneVector value) { return value >> shift; }
+#endif
+	constexpr size_t lanesPerVector = sizeof(LaneVector) / sizeof(uint64_t);
+
+	template<int shift>
+	LaneVector RotateLanesLeft(LaneVector value) {
+		return OrLanes(ShiftLanesLeft<shift>(value), ShiftLanesRight<64 - shift>(value));
+	}
+
+	// whether the engine has a Fill(first, count) method for bulk generation
+	template<typename Engine, typename = void>
+	struct HasFill : false_type {};
+
+	template<typename Engine>
+	struct HasFill<Engine, decltype((void)declval<Engine &>().Fill((uint64_t *)nullptr, size_t(0)))> : true_type {};
+}
+
+// a uniform integer in [0, range), or any 64-bit word if range is 0
+template<typename Engine>
+uint64_t UniformBelow(Engine &engine, uint64_t range) {
+	auto word = RandomDetail::GetWord(engine);
+	return range == 0 ? word : RandomDetail::MapBelow(engine, word, range);
+}
+
+class BlockRandomEngine;
+
+class Xoshiro256StarStar {
+public:
+	using result_type = uint64_t;
+	static constexpr result_type default_seed = 0x2545f4914f6cdd1dULL;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+	Xoshiro256StarStar() {
+		this->seed(default_seed);
+	}
+
+	explicit Xoshiro256StarStar(result_type value) {
+		this->seed(value);
+	}
+
+	// stream i of the seed, which starts i * 2^128 numbers after stream 0,
+	// so every thread of a pool can have its own stream of one seed
+	Xoshiro256StarStar(result_type value, size_t stream) {
+		this->seed(value);
+		for (size_t i = 0; i < stream; ++i)this->Jump();
+	}
+
+	void seed(result_type value = default_seed) {
+		for (auto &word : this->state)word = RandomDetail::SplitMix64(value);
+	}
+
+	// seeding from a seed sequence, as the standard engines do
+	template<typename SeedSeq, typename = typename enable_if<!is_convertible<SeedSeq, result_type>::value>::type>
+	void seed(SeedSeq &seeds) {
+		array<uint32_t, 8> words;
+		seeds.generate(words.begin(), words.end());
+		for (size_t i = 0; i < 4; ++i)this->state[i] = (uint64_t)words[2 * i] << 32 | words[2 * i + 1];
+		// the all-zero state is the one state the generator cannot leave
+		if ((this->state[0] | this->state[1] | this->state[2] | this->state[3]) == 0)this->seed(default_seed);
+	}
+
+	result_type operator()() {
+		auto result = RandomDetail::RotateLeft(this->state[1] * 5, 7) * 9;
+		auto shifted = this->state[1] << 17;
+		this->state[2] ^= this->state[0];
+		this->state[3] ^= this->state[1];
+		this->state[1] ^= this->state[2];
+		this->state[0] ^= this->state[3];
+		this->state[2] ^= shifted;
+		this->state[3] = RandomDetail::RotateLeft(this->state[3], 45);
+		return result;
+	}
+
+	void discard(unsigned long long count) {
+		for (; count > 0; --count)(*this)();
+	}
+
+	// the same numbers as count calls, for the interface of BlockRandomEngine
+	void Fill(result_type *first, size_t count) {
+		for (size_t i = 0; i < count; ++i)first[i] = (*this)();
+	}
+
+	// advances the generator by 2^128 numbers
+	void Jump() {
+		static const uint64_t polynomial[] = {
+			0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+		this->Advance(polynomial);
+	}
+
+	// advances the generator by 2^192 numbers, to split streams of streams
+	void LongJump() {
+		static const uint64_t polynomial[] = {
+			0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+		this->Advance(polynomial);
+	}
+
+	bool operator==(const Xoshiro256StarStar &other) const {
+		return this->state == other.state;
+	}
+
+	bool operator!=(const Xoshiro256StarStar &other) const {
+		return !(*this == other);
+	}
+
+private:
+	// it starts its lanes from the states of jumped generators
+	friend class BlockRandomEngine;
+
+	// multiplies the state by the jump polynomial
+	void Advance(const uint64_t *polynomial) {
+		array<uint64_t, 4> result{};
+		for (size_t i = 0; i < 4; ++i) {
+			for (int bit = 0; bit < 64; ++bit) {
+				if ((polynomial[i] >> bit) & 1) {
+					for (size_t j = 0; j < 4; ++j)result[j] ^= this->state[j];
+				}
+				(*this)();
+			}
+		}
+		this->state = result;
+	}
+
+	array<uint64_t, 4> state;
+};
+
+/*
+	numOfLanes xoshiro256** generators, lane i being stream i of the seed,
+	stepped together. The states are stored word by word across the lanes,
+	so one step is the same few operations on every lane, done on four
+	lanes per register with AVX2 or two with SSE2. With AVX2 it is faster
+	than Xoshiro256StarStar, with SSE2 about as fast. Fill() writes whole
+	blocks of numOfLanes numbers directly, and operator() hands out a
+	buffered block one number at a time. The numbers depend on the seed,
+	the stream and the sequence of calls, but not on the platform.
+*/
+class BlockRandomEngine {
+public:
+	using result_type = uint64_t;
+	static constexpr size_t numOfLanes = 8;
+	static constexpr size_t bufferSize = numOfLanes * 8;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+	BlockRandomEngine() {
+		this->seed(Xoshiro256StarStar::default_seed);
+	}
+
+	explicit BlockRandomEngine(result_type value, size_t stream = 0) {
+		this->seed(value, stream);
+	}
+
+	// the lanes of stream i start after those of streams [0, i)
+	void seed(result_type value, size_t stream = 0) {
+		Xoshiro256StarStar lane{ value, stream * numOfLanes };
+		for (size_t i = 0; i < numOfLanes; ++i) {
+			for (size_t word = 0; word < 4; ++word)this->state[word][i] = lane.state[word];
+			lane.Jump();
+		}
+		this->position = bufferSize;
+	}
+
+	result_type operator()() {
+		if (this->position == bufferSize) {
+			this->FillBlocks(this->buffer.data(), bufferSize / numOfLanes);
+			this->position = 0;
+		}
+		return this->buffer[this->position++];
+	}
+
+	void discard(unsigned long long count) {
+		for (; count > 0; --count)(*this)();
+	}
+
+	void Fill(result_type *first, size_t count) {
+		auto numOfBlocks = count / numOfLanes;
+		this->FillBlocks(first, numOfBlocks);
+		for (auto i = numOfBlocks * numOfLanes; i < count; ++i)first[i] = (*this)();
+	}
+
+private:
+	void FillBlocks(result_type *first, size_t numOfBlocks) {
+		using namespace RandomDetail;
+		const size_t numOfVectors = numOfLanes / lanesPerVector;
+		LaneVector s0[numOfVectors], s1[numOfVectors], s2[numOfVectors], s3[numOfVectors];
+		for (size_t i = 0; i < numOfVectors; ++i) {
+			s0[i] = LoadLanes(&this->state[0][i * lanesPerVector]);
+			s1[i] = LoadLanes(&this->state[1][i * lanesPerVector]);
+			s2[i] = LoadLanes(&this->state[2][i * lanesPerVector]);
+			s3[i] = LoadLanes(&this->state[3][i * lanesPerVector]);
+		}
+		for (size_t block = 0; block < numOfBlocks; ++block, first += numOfLanes) {
+			for (size_t i = 0; i < numOfVectors; ++i) {
+				// rotl(s1 * 5, 7) * 9
+				auto scaled = RotateLanesLeft<7>(AddLanes(s1[i], ShiftLanesLeft<2>(s1[i])));
+				StoreLanes(first + i * lanesPerVector, AddLanes(scaled, ShiftLanesLeft<3>(scaled)));
+				auto shifted = ShiftLanesLeft<17>(s1[i]);
+				s2[i] = XorLanes(s2[i], s0[i]);
+				s3[i] = XorLanes(s3[i], s1[i]);
+				s1[i] = XorLanes(s1[i], s2[i]);
+				s0[i] = XorLanes(s0[i], s3[i]);
+				s2[i] = XorLanes(s2[i], shifted);
+				s3[i] = RotateLanesLeft<45>(s3[i]);
+			}
+		}
+		for (size_t i = 0; i < numOfVectors; ++i) {
+			StoreLanes(&this->state[0][i * lanesPerVector], s0[i]);
+			StoreLanes(&this->state[1][i * lanesPerVector], s1[i]);
+			StoreLanes(&this->state[2][i * lanesPerVector], s2[i]);
+			StoreLanes(&this->state[3][i * lanesPerVector], s3[i]);
+		}
+	}
+
+	// state[word][lane]
+	uint64_t state[4][numOfLanes];
+	array<result_type, bufferSize> buffer;
+	size_t position{ bufferSize };
+};
+
+/*
+	A drop-in replacement of uniform_int_distribution, for integers of up
+	to 64 bits, drawing by Lemire's method. Like the standard one, the range
+	[a, b] is closed.
+*/
+template<typename IntType = int>
+class BoundedUniformIntDistribution {
+public:
+	static_assert(is_integral<IntType>::value && sizeof(IntType) <= 8, "the type should be an integer of up to 64 bits");
+	using result_type = IntType;
+
+	struct param_type {
+		using distribution_type = BoundedUniformIntDistribution;
+
+		explicit param_type(IntType _a = 0, IntType _b = numeric_limits<IntType>::max()) :lower{ _a }, upper{ _b } {}
+
+		IntType a() const { return this->lower; }
+		IntType b() const { return this->upper; }
+
+		bool operator==(const param_type &other) const { return this->lower == other.lower && this->upper == other.upper; }
+		bool operator!=(const param_type &other) const { return !(*this == other); }
+
+		IntType lower;
+		IntType upper;
+	};
+
+	BoundedUniformIntDistribution() :BoundedUniformIntDistribution(0) {}
+	explicit BoundedUniformIntDistribution(IntType a, IntType b = numeric_limits<IntType>::max()) :parameters{ a, b } {}
+	explicit BoundedUniformIntDistribution(const param_type &_parameters) :parameters{ _parameters } {}
+
+	// nothing is cached between draws
+	void reset() {}
+
+	template<typename Engine>
+	result_type operator()(Engine &engine) {
+		return (*this)(engine, this->parameters);
+	}
+
+	template<typename Engine>
+	result_type operator()(Engine &engine, const param_type &p) {
+		// b - a + 1 wraps to 0 for the full 64-bit range, which UniformBelow() takes as such
+		auto range = (uint64_t)p.upper - (uint64_t)p.lower + 1;
+		return (IntType)((uint64_t)p.lower + UniformBelow(engine, range));
+	}
+
+	IntType a() const { return this->parameters.a(); }
+	IntType b() const { return this->parameters.b(); }
+	IntType min() const { return this->a(); }
+	IntType max() const { return this->b(); }
+	param_type param() const { return this->parameters; }
+	void param(const param_type &_parameters) { this->parameters = _parameters; }
+
+private:
+	param_type parameters;
+};
+
+namespace RandomDetail {
+	// the words come in blocks from the engine's Fill()
+	template<typename Engine, typename IntType>
+	void FillBounded(Engine &engine, IntType *first, size_t count, IntType a, uint64_t range, true_type) {
+		const size_t blockSize = 256;
+		uint64_t words[blockSize];
+		while (count > 0) {
+			auto size = count < blockSize ? count : blockSize;
+			engine.Fill(words, size);
+			for (size_t i = 0; i < size; ++i) {
+				auto offset = range == 0 ? words[i] : MapBelow(engine, words[i], range);
+				first[i] = (IntType)((uint64_t)a + offset);
+			}
+			first += size;
+			count -= size;
+		}
+	}
+
+	template<typename Engine, typename IntType>
+	void FillBounded(Engine &engine, IntType *first, size_t count, IntType a, uint64_t range, false_type) {
+		for (size_t i = 0; i < count; ++i)first[i] = (IntType)((uint64_t)a + UniformBelow(engine, range));
+	}
+}
+
+// fills [first, first + count) with uniform integers in [a, b], in bulk
+// if the engine has a Fill() method, and one at a time otherwise
+template<typename Engine, typename IntType>
+void FillBounded(Engine &engine, IntType *first, size_t count, IntType a, IntType b) {
+	static_assert(is_integral<IntType>::value && sizeof(IntType) <= 8, "the type should be an integer of up to 64 bits");
+	auto range = (uint64_t)b - (uint64_t)a + 1;
+	using IsBulk = integral_constant<bool, RandomDetail::HasFill<Engine>::value && RandomDetail::IsFullWordEngine<Engine>::value>;
+	RandomDetail::FillBounded(engine, first, count, a, range, IsBulk{});
+}
+
+/*
+	Seeds engine with stream i of the seed, for a pool of threads sharing
+	one seed. The xoshiro engines jump to disjoint streams, and other
+	engines are seeded from a seed sequence of the seed and the stream.
+*/
+inline void SeedRandomStream(Xoshiro256StarStar &engine, uint64_t seed, size_t stream) {
+	engine = Xoshiro256StarStar{ seed, stream };
+}
+
+inline void SeedRandomStream(BlockRandomEngine &engine, uint64_t seed, size_t stream) {
+	engine.seed(seed, stream);
+}
+
+template<typename Engine>
+void SeedRandomStream(Engine &engine, uint64_t seed, size_t stream) {
+	seed_seq seeds{ (uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)stream, (uint32_t)((uint64_t)stream >> 32) };
+	engine.seed(seeds);
+}
+
+#endif
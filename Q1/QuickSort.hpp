@@ -8,6 +8,8 @@
 #include <random>
 #include <chrono>
 
+#include "../Common/ParallelRandom.hpp"
+
 using namespace std;
 
 /*
@@ -34,15 +36,18 @@ struct RightmostPivotPolicy {
 };
 
 // select a random pivot in the range [left, right]
-template<typename RAIter, typename RandomEngine = minstd_rand>
+template<typename RAIter, typename RandomEngine = Xoshiro256StarStar>
 struct RandomPivotPolicy {
 	RandomPivotPolicy() {
-		randomEngine.seed((int)chrono::system_clock::now().time_since_epoch().count());
+		randomEngine.seed((typename RandomEngine::result_type)chrono::system_clock::now().time_since_epoch().count());
+	}
+	// a fixed seed gives the same pivots on every run
+	explicit RandomPivotPolicy(typename RandomEngine::result_type seed) {
+		randomEngine.seed(seed);
 	}
 	RAIter operator()(RAIter left, RAIter right) {
 		auto iterDistance = distance(left, right);
-		uniform_int_distribution<> distribution(0, iterDistance);
-		auto offset = distribution(randomEngine);
+		auto offset = UniformBelow(randomEngine, (uint64_t)iterDistance + 1);
 		return left + offset;
 	}
 	RandomEngine randomEngine;
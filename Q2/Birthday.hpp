@@ -6,6 +6,8 @@
 #include <random>
 #include <chrono>
 
+#include "../Common/ParallelRandom.hpp"
+
 using namespace std;
 
 using IntType = int32_t;
@@ -16,7 +18,9 @@ static_assert(daysPerYear > 0, "there should be at least one day in a year");
 
 // this class is definitely NOT thread safe
 // this class avoids to create new objects just to boost performance
-template<IntType numOfPeople, typename RandomEngine = default_random_engine>
+// the birthdays are drawn in bulk when the engine has a Fill() method,
+// as BlockRandomEngine does
+template<IntType numOfPeople, typename RandomEngine = BlockRandomEngine>
 struct BirthdayUtility {
 	using ContainerType = vector<IntType>;
 
@@ -24,7 +28,14 @@ struct BirthdayUtility {
 
 	BirthdayUtility() {
 		// use the time now as the random seed
-		this->randomEngine.seed((int)chrono::system_clock::now().time_since_epoch().count());
+		this->randomEngine.seed((typename RandomEngine::result_type)chrono::system_clock::now().time_since_epoch().count());
+		this->days.resize(daysPerYear);
+		this->birthdays.resize(numOfPeople);
+	}
+
+	// a fixed seed makes the experiments reproducible
+	explicit BirthdayUtility(typename RandomEngine::result_type seed) {
+		this->randomEngine.seed(seed);
 		this->days.resize(daysPerYear);
 		this->birthdays.resize(numOfPeople);
 	}
@@ -50,9 +61,7 @@ struct BirthdayUtility {
 	}
 
 	void GenerateRandomBirthday() {
-		for (IntType i = 0; i < numOfPeople; ++i) {
-			this->birthdays[i] = this->distribution(randomEngine);
-		}
+		FillBounded(this->randomEngine, this->birthdays.data(), numOfPeople, 0, daysPerYear - 1);
 	}
 
 private:
@@ -66,7 +75,6 @@ private:
 	RandomEngine randomEngine;
 	vector<IntType> days;
 	vector<IntType> birthdays;
-	uniform_int_distribution<IntType> distribution{0, daysPerYear - 1};
 };
 
 
@@ -24,7 +24,7 @@ constexpr const IntType numOfAttempt = 300;
 // indicates the precision when printing floating point numbers
 constexpr const IntType floatingPointPrecision = 8;
 
-using BUtil = BirthdayUtility<numOfPeople, minstd_rand>;
+using BUtil = BirthdayUtility<numOfPeople>;
 
 FPType GetProbabilityOfPairsMoreThan(IntType numPair, BUtil &util) {
 	IntType success = 0;
@@ -54,7 +54,7 @@ struct Statistic {
 
 template<typename Iter>
 Statistic GetStatistic(Iter begin, Iter end) {
-	static_assert(is_same<Iter::value_type,FPType>::value, "incompatible value type");
+	static_assert(is_same<typename Iter::value_type,FPType>::value, "incompatible value type");
 
 	if (begin == end)throw runtime_error{ "no element received" };
 
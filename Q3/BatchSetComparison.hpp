@@ -0,0 +1,211 @@
+#ifndef DEF_BATCHSETCOMPARISON_HPP
+#define DEF_BATCHSETCOMPARISON_HPP
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <condition_variable>
+
+#include "../Common/ParallelRandom.hpp"
+#include "SetComparison.hpp"
+
+using namespace std;
+
+/*
+	A non-owning view of a contiguous range, which meets the container
+	requirements of SetComparison without copying the elements.
+*/
+template<typename Type>
+struct ArrayView {
+	using value_type = Type;
+	using const_iterator = const Type *;
+
+	ArrayView() {}
+	ArrayView(const Type *_data, size_t _size) :data{ _data }, length{ _size } {}
+
+	size_t size() const { return this->length; }
+	const Type *begin() const { return this->data; }
+	const Type *end() const { return this->data + this->length; }
+	const Type &operator[](size_t index) const { return this->data[index]; }
+
+	const Type *data{ nullptr };
+	size_t length{ 0 };
+};
+
+// locates a pair of sets inside one contiguous storage array
+struct SetPairDescriptor {
+	size_t leftOffset;
+	size_t leftSize;
+	size_t rightOffset;
+	size_t rightSize;
+};
+
+/*
+	Compares many small pairs of sets at once over a pool of threads.
+
+	The pairs are described by offsets into one contiguous storage array, and
+	the verdicts are written into a preallocated array, one per pair. Pairs are
+	handed out to the workers in chunks through an atomic counter. Every worker
+	owns its random engine (seeded with stream i of the base seed, see
+	SeedRandomStream(), so the streams of xoshiro engines never overlap)
+	and its scratch buffers, both of which live as long as the pool does,
+	so once the buffers have grown to the largest set no more memory is
+	allocated. The calling thread works as one of the workers.
+
+	The object is not meant to be shared: only one thread may call
+	the Compare* methods at a time.
+*/
+template<typename ValueType, typename RandomEngine = Xoshiro256StarStar>
+class BatchSetComparison {
+public:
+	using ViewType = ArrayView<ValueType>;
+	using SetComparisonType = SetComparison<ViewType, ViewType, RandomEngine>;
+
+	// the number of pairs a worker takes from the counter at a time
+	static constexpr size_t chunkSize = 256;
+
+	explicit BatchSetComparison(size_t numOfThreads = thread::hardware_concurrency()) :
+		BatchSetComparison(numOfThreads, (uint64_t)chrono::system_clock::now().time_since_epoch().count()) {}
+
+	BatchSetComparison(size_t numOfThreads, uint64_t seed) {
+		if (numOfThreads == 0)numOfThreads = 1;
+		this->workers.resize(numOfThreads);
+		for (size_t i = 0; i < numOfThreads; ++i) {
+			SeedRandomStream(this->workers[i].randomEngine, seed, i);
+		}
+		// the calling thread acts as worker 0
+		for (size_t i = 1; i < numOfThreads; ++i) {
+			this->threads.emplace_back(&BatchSetComparison::WorkerLoop, this, i);
+		}
+	}
+
+	BatchSetComparison(const BatchSetComparison &) = delete;
+	BatchSetComparison &operator=(const BatchSetComparison &) = delete;
+
+	~BatchSetComparison() {
+		{
+			lock_guard<mutex> lock{ this->jobMutex };
+			this->isStopping = true;
+		}
+		this->wakeCondition.notify_all();
+		for (auto &worker : this->threads)worker.join();
+	}
+
+	size_t GetNumOfThreads() const { return this->workers.size(); }
+
+	// exact verdicts, computed by sorting copies of both sets in scratch buffers
+	void CompareExact(const ValueType *storage, const SetPairDescriptor *pairs, size_t numOfPairs, bool *verdicts) {
+		this->Run(storage, pairs, numOfPairs, verdicts, 0.0);
+	}
+
+	// Monte-Carlo verdicts with the given false positive rate per pair,
+	// the sets may have different sizes
+	void CompareSampled(const ValueType *storage, const SetPairDescriptor *pairs, size_t numOfPairs,
+		double maxFalsePositiveRate, bool *verdicts) {
+		if (!(maxFalsePositiveRate > 0.0 && maxFalsePositiveRate < 1.0))
+			throw runtime_error{ "the false positive rate should be in (0, 1)" };
+		this->Run(storage, pairs, numOfPairs, verdicts, maxFalsePositiveRate);
+	}
+
+private:
+	struct Worker {
+		RandomEngine randomEngine;
+		vector<ValueType> leftScratch;
+		vector<ValueType> rightScratch;
+	};
+
+	void Run(const ValueType *storage, const SetPairDescriptor *pairs, size_t numOfPairs,
+		bool *verdicts, double maxFalsePositiveRate) {
+		{
+			lock_guard<mutex> lock{ this->jobMutex };
+			this->storage = storage;
+			this->pairs = pairs;
+			this->numOfPairs = numOfPairs;
+			this->verdicts = verdicts;
+			this->maxFalsePositiveRate = maxFalsePositiveRate;
+			this->nextPair.store(0);
+			this->numOfBusyThreads = this->threads.size();
+			++this->generation;
+		}
+		this->wakeCondition.notify_all();
+
+		this->ProcessPairs(this->workers[0]);
+
+		unique_lock<mutex> lock{ this->jobMutex };
+		this->doneCondition.wait(lock, [this]() { return this->numOfBusyThreads == 0; });
+	}
+
+	void WorkerLoop(size_t index) {
+		size_t seenGeneration = 0;
+		while (true) {
+			{
+				unique_lock<mutex> lock{ this->jobMutex };
+				this->wakeCondition.wait(lock, [&]() {
+					return this->isStopping || this->generation != seenGeneration;
+				});
+				if (this->isStopping)return;
+				seenGeneration = this->generation;
+			}
+
+			this->ProcessPairs(this->workers[index]);
+
+			lock_guard<mutex> lock{ this->jobMutex };
+			if (--this->numOfBusyThreads == 0)this->doneCondition.notify_one();
+		}
+	}
+
+	void ProcessPairs(Worker &worker) {
+		while (true) {
+			auto begin = this->nextPair.fetch_add(chunkSize);
+			if (begin >= this->numOfPairs)return;
+			auto end = min(begin + chunkSize, this->numOfPairs);
+
+			for (auto i = begin; i < end; ++i) {
+				const auto &pair = this->pairs[i];
+				ViewType left{ this->storage + pair.leftOffset, pair.leftSize };
+				ViewType right{ this->storage + pair.rightOffset, pair.rightSize };
+
+				if (this->maxFalsePositiveRate > 0.0) {
+					SetComparisonType comparison{ left, right, SizeMode::Tolerant, worker.randomEngine() };
+					this->verdicts[i] = comparison.Compare(this->maxFalsePositiveRate).isSame;
+				}
+				else {
+					this->verdicts[i] = IsSameSet(left, right, worker);
+				}
+			}
+		}
+	}
+
+	static bool IsSameSet(const ViewType &left, const ViewType &right, Worker &worker) {
+		// assign() reuses the capacity of the scratch buffers
+		worker.leftScratch.assign(left.begin(), left.end());
+		worker.rightScratch.assign(right.begin(), right.end());
+		return IsSameSetBySorting(worker.leftScratch, worker.rightScratch);
+	}
+
+	vector<Worker> workers;
+	vector<thread> threads;
+
+	// the current job, guarded by jobMutex when it is published
+	const ValueType *storage{ nullptr };
+	const SetPairDescriptor *pairs{ nullptr };
+	size_t numOfPairs{ 0 };
+	bool *verdicts{ nullptr };
+	double maxFalsePositiveRate{ 0.0 };
+	atomic<size_t> nextPair{ 0 };
+
+	mutex jobMutex;
+	condition_variable wakeCondition;
+	condition_variable doneCondition;
+	size_t generation{ 0 };
+	size_t numOfBusyThreads{ 0 };
+	bool isStopping{ false };
+};
+
+#endif
@@ -0,0 +1,418 @@
+#ifndef DEF_FILESETCOMPARISON_HPP
+#define DEF_FILESETCOMPARISON_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+#include "../Common/MappedFile.hpp"
+#include "../Common/ParallelRandom.hpp"
+#include "SetComparison.hpp"
+#include "BatchSetComparison.hpp"
+
+using namespace std;
+
+/*
+	Compares two sets stored in binary files of fixed-width elements
+	(the raw bytes of ValueType, one after another), which may be far larger
+	than the memory.
+
+	The exact verdict hash-partitions both files into bucket files, so that
+	equal elements always end up in buckets with the same index, and then
+	compares each pair of buckets in memory. One pass writes at most
+	maxNumOfBuckets bucket files per side, one side at a time, so the number
+	of open files stays bounded however large the input is. A pair of
+	buckets that is still larger than memoryBudget is partitioned again with
+	a new hash seed. Duplicates do not change the verdict, so they are
+	dropped from every block written to a bucket, which keeps a frequent
+	element from filling its bucket.
+
+	The sampled verdict runs the same Monte-Carlo test as SetComparison
+	with the same trial count. The sampled elements are read in sorted order
+	with their pages prefetched in batches, and then all of them are looked up
+	in the other file in one sequential pass, instead of one pass per sample.
+*/
+template<typename ValueType, typename RandomEngine = Xoshiro256StarStar>
+class FileSetComparison {
+public:
+	static_assert(is_trivially_copyable<ValueType>::value, "the value type should be trivially copyable");
+
+	using ViewType = ArrayView<ValueType>;
+	using SetComparisonType = SetComparison<ViewType, ViewType, RandomEngine>;
+	using CompareReport = typename SetComparisonType::CompareReport;
+
+	// the number of samples whose pages are prefetched together
+	static constexpr size_t sampleBatchSize = 64;
+	// the number of bucket files of one side a partitioning pass writes to
+	static constexpr size_t maxNumOfBuckets = 64;
+
+	FileSetComparison(const string &leftPath, const string &rightPath,
+		size_t _memoryBudget = size_t(256) << 20, const string &_tempDirectory = ".") :
+		leftFile{ leftPath }, rightFile{ rightPath },
+		memoryBudget{ _memoryBudget }, tempDirectory{ _tempDirectory } {
+		if (this->leftFile.GetSize() % sizeof(ValueType) != 0 || this->rightFile.GetSize() % sizeof(ValueType) != 0)
+			throw runtime_error{ "the file size is not a multiple of the element size" };
+		if (this->memoryBudget < sizeof(ValueType) * 2)
+			throw runtime_error{ "the memory budget is too small" };
+		this->randomEngine.seed((typename RandomEngine::result_type)chrono::system_clock::now().time_since_epoch().count());
+	}
+
+	size_t GetLeftSize() const { return this->leftFile.GetSize() / sizeof(ValueType); }
+	size_t GetRightSize() const { return this->rightFile.GetSize() / sizeof(ValueType); }
+
+	// the number of bucket pairs of the first pass of CompareExact(),
+	// 1 means no partitioning
+	size_t GetNumOfBuckets() const {
+		return this->GetNumOfBuckets((uint64_t)this->leftFile.GetSize() + this->rightFile.GetSize());
+	}
+
+	// exact set equality, duplicates are ignored
+	bool CompareExact() {
+		ElementSource left{ &this->leftFile, string{}, this->GetLeftSize() };
+		ElementSource right{ &this->rightFile, string{}, this->GetRightSize() };
+		return this->ComparePair(left, right, true);
+	}
+
+	/*
+		Monte-Carlo comparison with the given false positive rate. The sets may
+		have different sizes. Unlike SetComparison::Compare(), all trials are
+		run, and the report holds the first sample (in trial order) that is
+		missing from the other set.
+	*/
+	CompareReport CompareSampled(double maxFalsePositiveRate) {
+		ViewType left{ (const ValueType *)this->leftFile.GetData(), this->GetLeftSize() };
+		ViewType right{ (const ValueType *)this->rightFile.GetData(), this->GetRightSize() };
+
+		// only used for the trial count and the empty set cases, so
+		// the views are never dereferenced through this object
+		SetComparisonType comparison{ left, right, SizeMode::Tolerant, this->randomEngine() };
+		CompareReport report;
+		if (left.size() == 0 || right.size() == 0)return comparison.Compare(maxFalsePositiveRate);
+
+		report.numOfTrials = comparison.GetNumOfTrials(maxFalsePositiveRate);
+
+		this->DrawSamples(this->leftFile, left.size(), report.numOfTrials, this->leftSamples);
+		this->DrawSamples(this->rightFile, right.size(), report.numOfTrials, this->rightSamples);
+
+		auto leftMissing = this->FindFirstMissing(this->leftSamples, this->rightFile);
+		auto rightMissing = this->FindFirstMissing(this->rightSamples, this->leftFile);
+
+		// trial i checks left sample i before right sample i
+		if (leftMissing <= rightMissing && leftMissing < report.numOfTrials) {
+			this->FillMismatch(report, true, this->leftSamples[leftMissing]);
+		}
+		else if (rightMissing < report.numOfTrials) {
+			this->FillMismatch(report, false, this->rightSamples[rightMissing]);
+		}
+		return report;
+	}
+
+private:
+	struct Sample {
+		// the order in which the sample was drawn
+		size_t trial;
+		size_t index;
+		ValueType value;
+	};
+
+	// the elements of one side of a pair, a whole input file or a bucket file
+	struct ElementSource {
+		// nullptr for a bucket file
+		const MappedFile *file;
+		string path;
+		uint64_t numOfElements;
+	};
+
+	// owns the temporary bucket files of both sides of one partitioning pass
+	class BucketFiles {
+	public:
+		BucketFiles(const string &directory, size_t _numOfBuckets, size_t pass) :numOfBuckets{ _numOfBuckets } {
+			auto stamp = to_string(chrono::steady_clock::now().time_since_epoch().count());
+			this->prefix = directory + "/setcmp_" + stamp + "_" + to_string(pass) + "_";
+		}
+		~BucketFiles() {
+			for (size_t i = 0; i < this->numOfBuckets; ++i)this->Remove(i);
+		}
+		string GetPath(size_t side, size_t index) const {
+			return this->prefix + (side == 0 ? "l" : "r") + to_string(index) + ".bin";
+		}
+		size_t GetNumOfBuckets() const { return this->numOfBuckets; }
+		// removes both sides of a bucket pair once it has been compared
+		void Remove(size_t index) const {
+			for (size_t side = 0; side < 2; ++side)remove(this->GetPath(side, index).c_str());
+		}
+	private:
+		string prefix;
+		size_t numOfBuckets;
+	};
+
+	using FileHandle = unique_ptr<FILE, int(*)(FILE *)>;
+
+	// the number of elements read from a source at a time
+	static constexpr size_t readBlockLength = 1024;
+
+	static ValueType ReadElement(const MappedFile &file, size_t index) {
+		ValueType value;
+		memcpy(&value, file.GetData() + index * sizeof(ValueType), sizeof(ValueType));
+		return value;
+	}
+
+	// hashes the bytes of the element, so any trivially copyable type works
+	static uint64_t HashElement(const ValueType &value, uint64_t seed) {
+		unsigned char bytes[sizeof(ValueType)];
+		memcpy(bytes, &value, sizeof(ValueType));
+		uint64_t h = seed ^ 0xcbf29ce484222325ULL;
+		for (size_t i = 0; i < sizeof(ValueType); ++i) {
+			h = (h ^ bytes[i]) * 0x100000001b3ULL;
+		}
+		// the splitmix64 finalizer
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		return h ^ (h >> 31);
+	}
+
+	// the number of buckets to split totalSize bytes into
+	size_t GetNumOfBuckets(uint64_t totalSize) const {
+		if (totalSize <= this->memoryBudget)return 1;
+		// twice as many buckets as strictly needed, to leave room for uneven buckets
+		auto numOfBuckets = (totalSize / this->memoryBudget + 1) * 2;
+		return numOfBuckets < maxNumOfBuckets ? (size_t)numOfBuckets : maxNumOfBuckets;
+	}
+
+	/*
+		Compares a pair in memory if it fits in the budget. Otherwise both
+		sides are partitioned with a new seed and the pairs of buckets are
+		compared one by one. A pair that does not shrink by partitioning
+		holds elements that all hash alike under two seeds, which means a
+		few distinct elements, so it is loaded without duplicates instead.
+	*/
+	bool ComparePair(const ElementSource &left, const ElementSource &right, bool isSplittable) {
+		auto totalSize = (left.numOfElements + right.numOfElements) * sizeof(ValueType);
+		if (totalSize <= this->memoryBudget) {
+			this->Load(left, this->leftBucket);
+			this->Load(right, this->rightBucket);
+			return IsSameSetBySorting(this->leftBucket, this->rightBucket);
+		}
+		if (!isSplittable) {
+			this->LoadDistinct(left, this->leftBucket);
+			this->LoadDistinct(right, this->rightBucket);
+			return IsSameSetBySorting(this->leftBucket, this->rightBucket);
+		}
+
+		auto numOfBuckets = this->GetNumOfBuckets(totalSize);
+		// removes the bucket files however this method exits
+		BucketFiles buckets{ this->tempDirectory, numOfBuckets, this->numOfPasses++ };
+		auto seed = (uint64_t)this->randomEngine() << 32 | this->randomEngine();
+		vector<uint64_t> leftCounts(numOfBuckets, 0), rightCounts(numOfBuckets, 0);
+		this->Partition(left, buckets, 0, seed, leftCounts);
+		this->Partition(right, buckets, 1, seed, rightCounts);
+
+		for (size_t i = 0; i < numOfBuckets; ++i) {
+			// an element on one side only
+			if ((leftCounts[i] == 0) != (rightCounts[i] == 0))return false;
+			ElementSource leftBucketSource{ nullptr, buckets.GetPath(0, i), leftCounts[i] };
+			ElementSource rightBucketSource{ nullptr, buckets.GetPath(1, i), rightCounts[i] };
+			bool isShrunk = leftCounts[i] + rightCounts[i] < left.numOfElements + right.numOfElements;
+			if (!this->ComparePair(leftBucketSource, rightBucketSource, isShrunk))return false;
+			buckets.Remove(i);
+		}
+		return true;
+	}
+
+	// calls function(block, length) on consecutive blocks of the source,
+	// each of at most blockLength (up to readBlockLength) elements
+	template<typename Function>
+	void ReadSource(const ElementSource &source, Function &&function, size_t blockLength = readBlockLength) const {
+		ValueType buffer[readBlockLength];
+		blockLength = max<size_t>(1, min<size_t>(blockLength, (size_t)readBlockLength));
+		if (source.file != nullptr) {
+			source.file->Advise(MappedFile::AccessHint::Sequential);
+			for (uint64_t begin = 0; begin < source.numOfElements; begin += blockLength) {
+				auto length = (size_t)min<uint64_t>((uint64_t)blockLength, source.numOfElements - begin);
+				memcpy(buffer, source.file->GetData() + begin * sizeof(ValueType), length * sizeof(ValueType));
+				function(buffer, length);
+			}
+			return;
+		}
+		// nothing is written to an empty bucket, so its file might not exist
+		if (source.numOfElements == 0)return;
+		FileHandle file{ fopen(source.path.c_str(), "rb"), fclose };
+		if (file == nullptr)throw runtime_error{ "cannot read the bucket file " + source.path };
+		size_t numRead;
+		while ((numRead = fread(buffer, sizeof(ValueType), blockLength, file.get())) > 0) {
+			function(buffer, numRead);
+		}
+	}
+
+	void Load(const ElementSource &source, vector<ValueType> &output) const {
+		output.clear();
+		output.reserve((size_t)source.numOfElements);
+		this->ReadSource(source, [&](const ValueType *block, size_t length) {
+			output.insert(output.end(), block, block + length);
+		});
+	}
+
+	// loads the distinct elements of a source which may not fit in memory
+	// with its duplicates, using at most half of the budget
+	void LoadDistinct(const ElementSource &source, vector<ValueType> &output) const {
+		// the blocks are a quarter of the limit at most, so that a small
+		// budget is kept too rather than rounded up to a read block
+		auto limit = this->memoryBudget / 2 / sizeof(ValueType);
+		auto blockLength = max<size_t>(1, min<size_t>((size_t)readBlockLength, limit / 4));
+		output.clear();
+		this->ReadSource(source, [&](const ValueType *block, size_t length) {
+			output.insert(output.end(), block, block + length);
+			if (output.size() + blockLength <= limit)return;
+			sort(output.begin(), output.end());
+			output.erase(unique(output.begin(), output.end()), output.end());
+			if (output.size() + blockLength > limit / 2)
+				throw runtime_error{ "a bucket holds too many distinct elements for the memory budget" };
+		}, blockLength);
+	}
+
+	/*
+		Streams the source once and appends every element to the bucket
+		chosen by its hash, counting the elements written to each bucket.
+		Each bucket has a write buffer, so the bucket files are written in
+		large blocks, and duplicates are removed from a buffer before it is
+		written.
+	*/
+	void Partition(const ElementSource &source, const BucketFiles &buckets, size_t side, uint64_t seed,
+		vector<uint64_t> &counts) const {
+		auto numOfBuckets = buckets.GetNumOfBuckets();
+		// the buffers of all buckets take at most a quarter of the budget
+		size_t bufferLength = max<size_t>(1, min<size_t>(size_t(64) << 10, this->memoryBudget / 4 / numOfBuckets) / sizeof(ValueType));
+
+		vector<FileHandle> outputs;
+		outputs.reserve(numOfBuckets);
+		for (size_t i = 0; i < numOfBuckets; ++i)outputs.emplace_back(nullptr, fclose);
+		vector<vector<ValueType>> buffers(numOfBuckets);
+		auto flush = [&](size_t bucket) {
+			auto &buffer = buffers[bucket];
+			if (buffer.empty())return;
+			sort(buffer.begin(), buffer.end());
+			buffer.erase(unique(buffer.begin(), buffer.end()), buffer.end());
+			if (outputs[bucket] == nullptr)outputs[bucket].reset(fopen(buckets.GetPath(side, bucket).c_str(), "wb"));
+			if (outputs[bucket] == nullptr || fwrite(buffer.data(), sizeof(ValueType), buffer.size(), outputs[bucket].get()) != buffer.size())
+				throw runtime_error{ "cannot write the bucket file " + buckets.GetPath(side, bucket) };
+			counts[bucket] += buffer.size();
+			buffer.clear();
+		};
+
+		this->ReadSource(source, [&](const ValueType *block, size_t length) {
+			for (size_t i = 0; i < length; ++i) {
+				auto bucket = (size_t)(HashElement(block[i], seed) % numOfBuckets);
+				auto &buffer = buffers[bucket];
+				if (buffer.capacity() == 0)buffer.reserve(bufferLength);
+				buffer.push_back(block[i]);
+				if (buffer.size() == bufferLength)flush(bucket);
+			}
+		});
+		for (size_t i = 0; i < numOfBuckets; ++i)flush(i);
+		for (size_t i = 0; i < numOfBuckets; ++i) {
+			if (outputs[i] != nullptr && fclose(outputs[i].release()) != 0)
+				throw runtime_error{ "cannot write the bucket file " + buckets.GetPath(side, i) };
+		}
+	}
+
+	/*
+		Draws numOfSamples random elements. The indices are sorted first, so the
+		file is read front to back, and the pages of each batch are prefetched
+		before the batch is read.
+	*/
+	void DrawSamples(const MappedFile &file, size_t numOfElements, size_t numOfSamples, vector<Sample> &samples) {
+		BoundedUniformIntDistribution<size_t> distribution{ 0, numOfElements - 1 };
+		samples.resize(numOfSamples);
+		for (size_t i = 0; i < numOfSamples; ++i) {
+			samples[i].trial = i;
+			samples[i].index = distribution(this->randomEngine);
+		}
+		sort(samples.begin(), samples.end(), [](const Sample &left, const Sample &right) {
+			return left.index < right.index;
+		});
+
+		file.Advise(MappedFile::AccessHint::Random);
+		for (size_t begin = 0; begin < numOfSamples; begin += sampleBatchSize) {
+			auto end = min(begin + sampleBatchSize, numOfSamples);
+			for (auto i = begin; i < end; ++i) {
+				file.Prefetch(samples[i].index * sizeof(ValueType), sizeof(ValueType));
+			}
+			for (auto i = begin; i < end; ++i) {
+				samples[i].value = ReadElement(file, samples[i].index);
+			}
+		}
+
+		// back to trial order
+		sort(samples.begin(), samples.end(), [](const Sample &left, const Sample &right) {
+			return left.trial < right.trial;
+		});
+	}
+
+	/*
+		Looks for all samples in the file in one sequential pass, which ends
+		early once every sample has been found. Returns the trial of the first
+		missing sample, or the number of samples if none is missing.
+	*/
+	size_t FindFirstMissing(const vector<Sample> &samples, const MappedFile &file) {
+		this->probes.resize(samples.size());
+		for (size_t i = 0; i < samples.size(); ++i)this->probes[i] = samples[i].value;
+		sort(this->probes.begin(), this->probes.end());
+		this->probes.erase(unique(this->probes.begin(), this->probes.end()), this->probes.end());
+
+		this->isProbeFound.assign(this->probes.size(), false);
+		size_t numOfFound = 0;
+
+		file.Advise(MappedFile::AccessHint::Sequential);
+		auto numOfElements = file.GetSize() / sizeof(ValueType);
+		for (size_t i = 0; i < numOfElements && numOfFound < this->probes.size(); ++i) {
+			auto value = ReadElement(file, i);
+			auto iter = lower_bound(this->probes.begin(), this->probes.end(), value);
+			if (iter != this->probes.end() && !(value < *iter)) {
+				auto position = iter - this->probes.begin();
+				if (!this->isProbeFound[position]) {
+					this->isProbeFound[position] = true;
+					++numOfFound;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < samples.size(); ++i) {
+			auto position = lower_bound(this->probes.begin(), this->probes.end(), samples[i].value) - this->probes.begin();
+			if (!this->isProbeFound[position])return i;
+		}
+		return samples.size();
+	}
+
+	static void FillMismatch(CompareReport &report, bool isLeft, const Sample &sample) {
+		report.isSame = false;
+		report.isLeftMismatch = isLeft;
+		report.mismatchIndex = sample.index;
+		report.value = sample.value;
+	}
+
+	MappedFile leftFile;
+	MappedFile rightFile;
+	size_t memoryBudget;
+	string tempDirectory;
+	RandomEngine randomEngine;
+	// numbers the partitioning passes, to name their bucket files apart
+	size_t numOfPasses{ 0 };
+
+	// scratch buffers reused between calls
+	vector<ValueType> leftBucket;
+	vector<ValueType> rightBucket;
+	vector<Sample> leftSamples;
+	vector<Sample> rightSamples;
+	vector<ValueType> probes;
+	vector<bool> isProbeFound;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef DEF_MULTIPROBESCAN_HPP
+#define DEF_MULTIPROBESCAN_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MULTIPROBESCAN_USE_SSE2
+#endif
+
+using namespace std;
+
+// the largest number of probes MultiProbeScan() handles at once
+constexpr size_t maxNumOfProbes = 64;
+
+template<typename Type>
+struct IsMultiProbeScannable {
+	static constexpr bool value = (is_integral<Type>::value || is_enum<Type>::value)
+		&& (sizeof(Type) == 1 || sizeof(Type) == 2 || sizeof(Type) == 4 || sizeof(Type) == 8);
+};
+
+namespace MultiProbeDetail {
+	// the number of 16-byte blocks scanned between checks for early exit
+	constexpr size_t blocksPerCheck = 64;
+
+	template<typename Type>
+	uint64_t ScanScalar(const Type *data, size_t size, const Type *probes, size_t numOfProbes, uint64_t found) {
+		auto allFound = (numOfProbes == 64) ? ~uint64_t(0) : ((uint64_t(1) << numOfProbes) - 1);
+		for (size_t i = 0; i < size && found != allFound; ++i) {
+			for (size_t p = 0; p < numOfProbes; ++p) {
+				if (data[i] == probes[p])found |= uint64_t(1) << p;
+			}
+		}
+		return found;
+	}
+
+#ifdef MULTIPROBESCAN_USE_SSE2
+	template<size_t size>
+	struct SimdEqual;
+
+	template<>
+	struct SimdEqual<1> {
+		static __m128i Broadcast(const void *value) { int8_t v; memcpy(&v, value, 1); return _mm_set1_epi8(v); }
+		static __m128i Equal(__m128i left, __m128i right) { return _mm_cmpeq_epi8(left, right); }
+	};
+
+	template<>
+	struct SimdEqual<2> {
+		static __m128i Broadcast(const void *value) { int16_t v; memcpy(&v, value, 2); return _mm_set1_epi16(v); }
+		static __m128i Equal(__m128i left, __m128i right) { return _mm_cmpeq_epi16(left, right); }
+	};
+
+	template<>
+	struct SimdEqual<4> {
+		static __m128i Broadcast(const void *value) { int32_t v; memcpy(&v, value, 4); return _mm_set1_epi32(v); }
+		static __m128i Equal(__m128i left, __m128i right) { return _mm_cmpeq_epi32(left, right); }
+	};
+
+	template<>
+	struct SimdEqual<8> {
+		static __m128i Broadcast(const void *value) {
+			int32_t v[2];
+			memcpy(v, value, 8);
+			return _mm_set_epi32(v[1], v[0], v[1], v[0]);
+		}
+		// SSE2 has no 64-bit comparison, so both 32-bit halves have to match
+		static __m128i Equal(__m128i left, __m128i right) {
+			auto halves = _mm_cmpeq_epi32(left, right);
+			return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+		}
+	};
+#endif
+}
+
+/*
+	Looks for up to 64 probes in [data, data + size) in a single pass.
+	Every 16-byte block of data is loaded once and compared against all
+	probes broadcast into SIMD registers, so the data is read once instead
+	of once per probe. The scan stops early when all probes have been found.
+	Bit i of the result is set if probes[i] occurs in the data.
+*/
+template<typename Type>
+uint64_t MultiProbeScan(const Type *data, size_t size, const Type *probes, size_t numOfProbes) {
+	static_assert(IsMultiProbeScannable<Type>::value, "only integral types of 1, 2, 4 or 8 bytes are supported");
+	if (numOfProbes > maxNumOfProbes)throw runtime_error{ "too many probes" };
+	if (numOfProbes == 0)return 0;
+
+	uint64_t found = 0;
+	size_t scanned = 0;
+
+#ifdef MULTIPROBESCAN_USE_SSE2
+	using Simd = MultiProbeDetail::SimdEqual<sizeof(Type)>;
+	const size_t lanes = 16 / sizeof(Type);
+	auto allFound = (numOfProbes == 64) ? ~uint64_t(0) : ((uint64_t(1) << numOfProbes) - 1);
+
+	__m128i broadcast[maxNumOfProbes];
+	__m128i matches[maxNumOfProbes];
+	for (size_t p = 0; p < numOfProbes; ++p) {
+		broadcast[p] = Simd::Broadcast(probes + p);
+		matches[p] = _mm_setzero_si128();
+	}
+
+	size_t numOfBlocks = size / lanes;
+	for (size_t block = 0; block < numOfBlocks && found != allFound; ) {
+		auto checkEnd = block + MultiProbeDetail::blocksPerCheck;
+		if (checkEnd > numOfBlocks)checkEnd = numOfBlocks;
+		for (; block < checkEnd; ++block) {
+			auto chunk = _mm_loadu_si128((const __m128i *)(data + block * lanes));
+			for (size_t p = 0; p < numOfProbes; ++p) {
+				matches[p] = _mm_or_si128(matches[p], Simd::Equal(chunk, broadcast[p]));
+			}
+		}
+		for (size_t p = 0; p < numOfProbes; ++p) {
+			if (_mm_movemask_epi8(matches[p]) != 0)found |= uint64_t(1) << p;
+		}
+	}
+	scanned = numOfBlocks * lanes;
+#endif
+
+	// the tail, or everything if SSE2 is not available
+	return MultiProbeDetail::ScanScalar(data + scanned, size - scanned, probes, numOfProbes, found);
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef DEF_MULTISETFINGERPRINT_HPP
+#define DEF_MULTISETFINGERPRINT_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <functional>
+
+#include "../Common/ParallelRandom.hpp"
+
+using namespace std;
+
+/*
+	An order-independent fingerprint of a multiset.
+
+	Every element is hashed by Hasher, then the hash is mixed with a random
+	key and reduced modulo the Mersenne prime p = 2^61 - 1. The fingerprint
+	is the sum of the mixed hashes modulo p, computed independently in
+	numOfLanes lanes (each lane has its own random key). Since addition is
+	commutative, the order of the elements does not matter, and inserting
+	or erasing an element only adds or subtracts one term, which is O(1).
+
+	The false positive rate is only as good as the hash. Two elements whose
+	Hasher values are equal can never be told apart, and the keyed mixer is
+	not a universal hash, so the lanes are only assumed to behave like
+	independent random values in [0, p). Under that assumption, two
+	different multisets collide in each lane with a probability of about
+	1/p, and in all of them with about p^(-numOfLanes).
+	Two fingerprints are only comparable if they are built with the same keys,
+	so copy the fingerprint (or call CreateEmpty()) instead of constructing
+	a new one for the other side.
+*/
+template<typename ValueType, size_t numOfLanes = 2, typename Hasher = hash<ValueType>>
+class MultisetFingerprint {
+public:
+	using LaneArrayType = array<uint64_t, numOfLanes>;
+
+	static_assert(numOfLanes > 0, "there should be at least one lane");
+
+	static constexpr uint64_t modulus = (uint64_t(1) << 61) - 1;
+
+	MultisetFingerprint() {
+		// use the time now as the random seed
+		this->GenerateKeys((uint64_t)chrono::system_clock::now().time_since_epoch().count());
+	}
+
+	explicit MultisetFingerprint(uint64_t seed) {
+		this->GenerateKeys(seed);
+	}
+
+	// returns a fingerprint of the empty multiset sharing the keys with this one
+	MultisetFingerprint CreateEmpty() const {
+		MultisetFingerprint result{ *this };
+		result.Clear();
+		return result;
+	}
+
+	void Clear() {
+		this->sums.fill(0);
+		this->count = 0;
+	}
+
+	void Insert(const ValueType &value) {
+		auto valueHash = (uint64_t)this->hasher(value);
+		for (size_t i = 0; i < numOfLanes; ++i) {
+			this->sums[i] = AddMod(this->sums[i], this->MixHash(valueHash, i));
+		}
+		++this->count;
+	}
+
+	// the caller is responsible to make sure that the value is in the multiset
+	void Erase(const ValueType &value) {
+		auto valueHash = (uint64_t)this->hasher(value);
+		for (size_t i = 0; i < numOfLanes; ++i) {
+			this->sums[i] = SubMod(this->sums[i], this->MixHash(valueHash, i));
+		}
+		--this->count;
+	}
+
+	/*
+		Adds all elements in [begin, end) in one pass. The loop keeps four
+		independent accumulators per lane so that there is no dependency
+		between consecutive elements, which lets the compiler vectorize
+		and pipeline the mixing.
+	*/
+	template<typename Iter>
+	void InsertRange(Iter begin, Iter end) {
+		const size_t blockSize = 4;
+		uint64_t blockSums[numOfLanes][blockSize] = {};
+		uint64_t blockHashes[blockSize];
+
+		size_t filled = 0;
+		for (; begin != end; ++begin) {
+			blockHashes[filled++] = (uint64_t)this->hasher(*begin);
+			if (filled == blockSize) {
+				for (size_t i = 0; i < numOfLanes; ++i) {
+					for (size_t j = 0; j < blockSize; ++j) {
+						blockSums[i][j] = AddMod(blockSums[i][j], this->MixHash(blockHashes[j], i));
+					}
+				}
+				this->count += blockSize;
+				filled = 0;
+			}
+		}
+
+		for (size_t i = 0; i < numOfLanes; ++i) {
+			for (size_t j = 0; j < filled; ++j) {
+				blockSums[i][j] = AddMod(blockSums[i][j], this->MixHash(blockHashes[j], i));
+			}
+			for (size_t j = 0; j < blockSize; ++j) {
+				this->sums[i] = AddMod(this->sums[i], blockSums[i][j]);
+			}
+		}
+		this->count += filled;
+	}
+
+	template<typename Container>
+	void InsertAll(const Container &container) {
+		this->InsertRange(container.begin(), container.end());
+	}
+
+	size_t GetCount() const { return this->count; }
+	const LaneArrayType &GetSums() const { return this->sums; }
+
+	// the probability that two different multisets are reported as equal,
+	// assuming that Hasher never maps two of their elements to one value
+	// and that the mixed hashes behave like random values
+	static double GetFalsePositiveBound() {
+		return pow(1.0 / (double)modulus, (double)numOfLanes);
+	}
+
+	// the same, but only assuming that Hasher spreads the numOfElements
+	// distinct elements of both multisets like a random 64-bit function,
+	// which adds the probability that two of them share a hash
+	static double GetFalsePositiveBound(size_t numOfElements) {
+		auto n = (double)numOfElements;
+		return GetFalsePositiveBound() + n * (n - 1) / 2.0 / pow(2.0, 64);
+	}
+
+	bool operator==(const MultisetFingerprint &other) const {
+		return this->count == other.count && this->sums == other.sums;
+	}
+
+	bool operator!=(const MultisetFingerprint &other) const {
+		return !(*this == other);
+	}
+
+private:
+	void GenerateKeys(uint64_t seed) {
+		Xoshiro256StarStar randomEngine{ seed };
+		for (auto &key : this->keys)key = randomEngine();
+		this->Clear();
+	}
+
+	// the splitmix64 finalizer, reduced into [0, modulus)
+	uint64_t MixHash(uint64_t valueHash, size_t lane) const {
+		uint64_t x = valueHash ^ this->keys[lane];
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		x = x ^ (x >> 31);
+		return ReduceMod(x);
+	}
+
+	// both operands should be in [0, modulus)
+	static uint64_t AddMod(uint64_t left, uint64_t right) {
+		return ReduceMod(left + right);
+	}
+
+	static uint64_t SubMod(uint64_t left, uint64_t right) {
+		return ReduceMod(left + modulus - right);
+	}
+
+	// x mod (2^61 - 1) without division, valid for all 64-bit values
+	static uint64_t ReduceMod(uint64_t x) {
+		x = (x & modulus) + (x >> 61);
+		return x >= modulus ? x - modulus : x;
+	}
+
+	Hasher hasher;
+	LaneArrayType keys;
+	LaneArrayType sums;
+	size_t count{ 0 };
+};
+
+// checks whether two containers hold the same multiset of elements,
+// with the false positive rate of GetFalsePositiveBound()
+template<size_t numOfLanes = 2, typename LeftCType, typename RightCType>
+bool IsMultisetEqual(const LeftCType &left, const RightCType &right) {
+	if (left.size() != right.size())return false;
+	MultisetFingerprint<typename LeftCType::value_type, numOfLanes> leftFingerprint;
+	auto rightFingerprint = leftFingerprint.CreateEmpty();
+	leftFingerprint.InsertAll(left);
+	rightFingerprint.InsertAll(right);
+	return leftFingerprint == rightFingerprint;
+}
+
+#endif
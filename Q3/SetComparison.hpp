@@ -4,27 +4,84 @@
 #include <chrono>
 #include <random>
 #include <memory>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 #include <algorithm>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Common/ParallelRandom.hpp"
+#include "SetReconciliation.hpp"
+#include "MultiProbeScan.hpp"
 
 using namespace std;
 
+// how SetComparison deals with sets of different sizes
+enum class SizeMode {
+	// sets must have the same non-zero size, otherwise UpdateSize() throws
+	Strict,
+	// sets may have any size, including zero
+	Tolerant
+};
+
+// tells SetComparison that both containers are sorted in ascending order
+struct SortedInputTag {};
+
+// whether a < b compiles for two values of the type
+template<typename Type, typename = void>
+struct IsLessComparable : false_type {};
+
+template<typename Type>
+struct IsLessComparable<Type, decltype((void)(declval<const Type &>() < declval<const Type &>()))> : true_type {};
+
+// whether the container stores its elements contiguously behind data()
+template<typename Container, typename = void>
+struct HasContiguousData : false_type {};
+
+template<typename Container>
+struct HasContiguousData<Container, decltype((void)declval<const Container &>().data())> : true_type {};
+
+/*
+	Exact set equality (duplicates are ignored) by sorting both containers
+	in place. The containers are usually scratch buffers whose capacity is
+	reused by the caller.
+*/
+template<typename ScratchContainer>
+bool IsSameSetBySorting(ScratchContainer &left, ScratchContainer &right) {
+	sort(left.begin(), left.end());
+	sort(right.begin(), right.end());
+	auto leftEnd = unique(left.begin(), left.end());
+	auto rightEnd = unique(right.begin(), right.end());
+	return (leftEnd - left.begin()) == (rightEnd - right.begin())
+		&& equal(left.begin(), leftEnd, right.begin());
+}
+
 /*
 	Both containers should support operator[] element access
-	and have size(), begin(), end() method and value_type trait. 
-	Once the class is constructed, it is assumed that the size of both sets 
+	and have size(), begin(), end() method and value_type trait.
+	Once the class is constructed, it is assumed that the size of both sets
 	stays fixed. If the size changes, call the UpdateSize() method.
+
+	If a container is sorted (given by SortedInputTag or found by
+	DetectSortedness()), elements are looked up in it by binary search
+	instead of a linear scan, and CompareExact() / GetDifference() answer
+	with one merge pass instead of sorting copies of both sets.
 */
-template<typename LeftCType, typename RightCType, typename RandomEngine = default_random_engine>
+template<typename LeftCType, typename RightCType, typename RandomEngine = Xoshiro256StarStar>
 class SetComparison {
 private:
-	using DistributionType = uniform_int_distribution<size_t>;
-	using DistributionPtrType = unique_ptr<DistributionType>;
+	using DistributionType = BoundedUniformIntDistribution<size_t>;
+
+	// the number of random picks generated at once by Compare()
+	static constexpr size_t pickBatchSize = 32;
 public:
 	using LeftContainerType = LeftCType;
 	using RightContainerType = RightCType;
 
-	static_assert(is_same<typename LeftContainerType::value_type, 
+	static_assert(is_same<typename LeftContainerType::value_type,
 		typename RightContainerType::value_type>::value,
 		"left and right value type mismatch");
 
@@ -34,26 +91,87 @@ public:
 		bool isSame = false;
 		unique_ptr<ValueType> value{ nullptr };
 	};
+
+	// the result of Compare(), which is returned by value without any allocation
+	struct CompareReport {
+		bool isSame = true;
+		// whether the mismatched element comes from the left set
+		bool isLeftMismatch = false;
+		// the index of the mismatched element in its own container
+		size_t mismatchIndex = numeric_limits<size_t>::max();
+		ValueType value{};
+		// the number of trials actually run
+		size_t numOfTrials = 0;
+	};
+
+	// the result of CompareBatched()
+	struct MultiProbeReport {
+		bool isSame = true;
+		size_t numOfProbes = 0;
+		// the picked indices in the left and the right container
+		array<size_t, maxNumOfProbes> leftPicks;
+		array<size_t, maxNumOfProbes> rightPicks;
+		// bit i is set if the element at leftPicks[i] was found in the right
+		// container, and likewise for rightFound
+		uint64_t leftFound = 0;
+		uint64_t rightFound = 0;
+	};
 public:
 
-	SetComparison(const LeftContainerType &left, const RightContainerType &right):
-		leftContainer{ left }, rightContainer{ right } {
+	SetComparison(const LeftContainerType &left, const RightContainerType &right, SizeMode mode = SizeMode::Strict):
+		leftContainer{ left }, rightContainer{ right }, sizeMode{ mode } {
+		this->UpdateSize();
+		this->randomEngine.seed((typename RandomEngine::result_type)chrono::system_clock::now().time_since_epoch().count());
+	}
+
+	// uses the given seed instead of the time now, mostly for callers
+	// that keep their own random stream (e.g. one per thread)
+	SetComparison(const LeftContainerType &left, const RightContainerType &right, SizeMode mode,
+		typename RandomEngine::result_type seed):
+		leftContainer{ left }, rightContainer{ right }, sizeMode{ mode } {
 		this->UpdateSize();
-		this->randomEngine.seed((int)chrono::system_clock::now().time_since_epoch().count());
+		this->randomEngine.seed(seed);
+	}
+
+	// the caller promises that both containers are sorted in ascending order
+	SetComparison(const LeftContainerType &left, const RightContainerType &right, SortedInputTag,
+		SizeMode mode = SizeMode::Strict):
+		SetComparison(left, right, mode) {
+		static_assert(IsLessComparable<ValueType>::value, "sorted input requires operator<");
+		this->isLeftSorted = true;
+		this->isRightSorted = true;
+	}
+
+	/*
+		Checks whether each container is sorted, which takes O(n) time.
+		Call it again after the containers are modified, or the result of
+		the binary search might be wrong.
+	*/
+	void DetectSortedness() {
+		this->isLeftSorted = this->DetectSortedness(leftContainer, IsLessComparable<ValueType>{});
+		this->isRightSorted = this->DetectSortedness(rightContainer, IsLessComparable<ValueType>{});
 	}
 
+	bool IsLeftSorted() const { return this->isLeftSorted; }
+	bool IsRightSorted() const { return this->isRightSorted; }
+
 	void UpdateSize() {
-		if(leftContainer.size() != rightContainer.size())throw runtime_error{ "the size of two set is different" };
-		if (leftContainer.size() == 0)throw runtime_error{ "the sets are empty" };
-		this->distribution.get_deleter()(this->distribution.get());
-		this->distribution = move(make_unique<DistributionType>(0, leftContainer.size() - 1));
+		if (this->sizeMode == SizeMode::Strict) {
+			if (leftContainer.size() != rightContainer.size())throw runtime_error{ "the size of two set is different" };
+			if (leftContainer.size() == 0)throw runtime_error{ "the sets are empty" };
+		}
+		// the distributions are only reparameterized, nothing is reallocated
+		if (leftContainer.size() > 0)
+			this->leftDistribution.param(DistributionType::param_type{ 0, leftContainer.size() - 1 });
+		if (rightContainer.size() > 0)
+			this->rightDistribution.param(DistributionType::param_type{ 0, rightContainer.size() - 1 });
 	}
 
 	/*
 		We pick one element from the left set to check whether it is in the
 		right set, and then pick one element from the right set to check
 		whether it is in the left set. If both statements are true, it indicates
-		the two sets might be equal; otherwise, the two sets must not be equal. 
+		the two sets might be equal; otherwise, the two sets must not be equal.
 		So this Monte-Carlo method is false-biased.
 	*/
 	bool CompareOnce() {
@@ -62,20 +180,19 @@ public:
 		bool leftTest, rightTest;
 
 		// pick an element from the left
-		auto leftPick = this->distribution->operator()(this->randomEngine);
+		auto leftPick = this->leftDistribution(this->randomEngine);
 		const auto &leftElement = leftContainer[leftPick];
-		// using std::find to look for the left element in the right set
-		auto rightFindIter = find(rightContainer.begin(), rightContainer.end(), leftElement);
-		leftTest = (rightFindIter != rightContainer.end());
+		// look for the left element in the right set, using std::find
+		// or binary search if the right set is sorted
+		leftTest = this->IsInRight(leftElement);
 
 		// if leftTest is false, return false to avoid furthur process
 		if (!leftTest)return false;
 
-		auto rightPick = this->distribution->operator()(this->randomEngine);
+		auto rightPick = this->rightDistribution(this->randomEngine);
 		const auto &rightElement = rightContainer[rightPick];
-		auto leftFindIter = find(leftContainer.begin(), leftContainer.end(), rightElement);
-		rightTest = (leftFindIter != leftContainer.end());
-		
+		rightTest = this->IsInLeft(rightElement);
+
 		return rightTest;
 	}
 
@@ -86,11 +203,11 @@ public:
 		bool leftTest, rightTest;
 
 		// pick an element from the left
-		auto leftPick = this->distribution->operator()(this->randomEngine);
+		auto leftPick = this->leftDistribution(this->randomEngine);
 		const auto &leftElement = leftContainer[leftPick];
-		// using std::find to look for the left element in the right set
-		auto rightFindIter = find(rightContainer.begin(), rightContainer.end(), leftElement);
-		leftTest = (rightFindIter != rightContainer.end());
+		// look for the left element in the right set, using std::find
+		// or binary search if the right set is sorted
+		leftTest = this->IsInRight(leftElement);
 
 		// if leftTest is false, return false to avoid furthur process
 		if (!leftTest) {
@@ -99,10 +216,9 @@ public:
 			return result;
 		}
 
-		auto rightPick = this->distribution->operator()(this->randomEngine);
+		auto rightPick = this->rightDistribution(this->randomEngine);
 		const auto &rightElement = rightContainer[rightPick];
-		auto leftFindIter = find(leftContainer.begin(), leftContainer.end(), rightElement);
-		rightTest = (leftFindIter != leftContainer.end());
+		rightTest = this->IsInLeft(rightElement);
 
 		if (!rightTest) {
 			result.isSame = false;
@@ -113,11 +229,290 @@ public:
 		result.isSame = true;
 		return result;
 	}
+
+	/*
+		Returns the number of trials needed so that two different sets are
+		reported as equal with a probability of at most maxFalsePositiveRate.
+
+		Suppose the larger set has n elements. If the sets are different and
+		have the same size, both of them hold at least one element missing from
+		the other, so a trial fails to notice it with a probability of at most
+		(1 - 1/n)^2. If the sizes may differ, only one side is guaranteed to
+		have such an element, and the bound becomes (1 - 1/n).
+	*/
+	size_t GetNumOfTrials(double maxFalsePositiveRate) const {
+		if (!(maxFalsePositiveRate > 0.0 && maxFalsePositiveRate < 1.0))
+			throw runtime_error{ "the false positive rate should be in (0, 1)" };
+		auto n = max(leftContainer.size(), rightContainer.size());
+		if (n <= 1)return 1;
+
+		bool isBothSided = (this->sizeMode == SizeMode::Strict || leftContainer.size() == rightContainer.size());
+		double missPerTrial = (isBothSided ? 2.0 : 1.0) * log1p(-1.0 / (double)n);
+		return (size_t)ceil(log(maxFalsePositiveRate) / missPerTrial);
+	}
+
+	/*
+		Runs as many trials as GetNumOfTrials() requires and stops at the
+		first mismatch. The random picks are generated in batches, and the
+		report is returned inline, so nothing is allocated.
+	*/
+	CompareReport Compare(double maxFalsePositiveRate) {
+		CompareReport report;
+
+		auto leftSize = leftContainer.size();
+		auto rightSize = rightContainer.size();
+		if (leftSize == 0 || rightSize == 0) {
+			// only reachable in the size-tolerant mode
+			report.isSame = (leftSize == rightSize);
+			if (!report.isSame) {
+				report.isLeftMismatch = (leftSize > 0);
+				report.mismatchIndex = 0;
+				report.value = report.isLeftMismatch ? leftContainer[0] : rightContainer[0];
+			}
+			return report;
+		}
+
+		auto numOfTrials = this->GetNumOfTrials(maxFalsePositiveRate);
+
+		array<size_t, pickBatchSize> leftPicks, rightPicks;
+		while (report.numOfTrials < numOfTrials) {
+			size_t batchSize = numOfTrials - report.numOfTrials;
+			if (batchSize > pickBatchSize)batchSize = pickBatchSize;
+			FillBounded(this->randomEngine, leftPicks.data(), batchSize, size_t(0), leftSize - 1);
+			FillBounded(this->randomEngine, rightPicks.data(), batchSize, size_t(0), rightSize - 1);
+
+			for (size_t i = 0; i < batchSize; ++i) {
+				++report.numOfTrials;
+				const auto &leftElement = leftContainer[leftPicks[i]];
+				if (!this->IsInRight(leftElement)) {
+					this->FillMismatch(report, true, leftPicks[i], leftElement);
+					return report;
+				}
+				const auto &rightElement = rightContainer[rightPicks[i]];
+				if (!this->IsInLeft(rightElement)) {
+					this->FillMismatch(report, false, rightPicks[i], rightElement);
+					return report;
+				}
+			}
+		}
+
+		return report;
+	}
+
+	/*
+		Runs numOfProbes trials at once for integral value types: picks
+		numOfProbes elements from each side up front, then looks for all of
+		them in the other container with a single SIMD pass (see
+		MultiProbeScan()), so each container is read once instead of once per
+		trial. Both containers should store their elements contiguously.
+	*/
+	MultiProbeReport CompareBatched(size_t numOfProbes) {
+		static_assert(IsMultiProbeScannable<ValueType>::value, "the value type is not supported by MultiProbeScan()");
+		static_assert(HasContiguousData<LeftContainerType>::value && HasContiguousData<RightContainerType>::value,
+			"the containers should provide data()");
+		if (numOfProbes == 0 || numOfProbes > maxNumOfProbes)
+			throw runtime_error{ "the number of probes should be in [1, 64]" };
+
+		MultiProbeReport report;
+		auto leftSize = leftContainer.size();
+		auto rightSize = rightContainer.size();
+		if (leftSize == 0 || rightSize == 0) {
+			// only reachable in the size-tolerant mode
+			report.isSame = (leftSize == rightSize);
+			return report;
+		}
+
+		array<ValueType, maxNumOfProbes> leftProbes, rightProbes;
+		FillBounded(this->randomEngine, report.leftPicks.data(), numOfProbes, size_t(0), leftSize - 1);
+		FillBounded(this->randomEngine, report.rightPicks.data(), numOfProbes, size_t(0), rightSize - 1);
+		for (size_t i = 0; i < numOfProbes; ++i) {
+			leftProbes[i] = leftContainer[report.leftPicks[i]];
+			rightProbes[i] = rightContainer[report.rightPicks[i]];
+		}
+		report.numOfProbes = numOfProbes;
+
+		auto allFound = (numOfProbes == 64) ? ~uint64_t(0) : ((uint64_t(1) << numOfProbes) - 1);
+		report.leftFound = MultiProbeScan(rightContainer.data(), rightSize, leftProbes.data(), numOfProbes);
+		report.rightFound = MultiProbeScan(leftContainer.data(), leftSize, rightProbes.data(), numOfProbes);
+		report.isSame = (report.leftFound == allFound && report.rightFound == allFound);
+		return report;
+	}
+
+	/*
+		Recovers every element in the symmetric difference at once with an
+		invertible Bloom lookup table instead of one element per call. Only
+		available for integral value types. Returns false if the difference
+		is much larger than expectedDifference.
+	*/
+	template<typename OutputContainer>
+	bool ReconcileDifference(size_t expectedDifference, OutputContainer &leftOnly, OutputContainer &rightOnly) const {
+		return ReconcileSets(leftContainer, rightContainer, expectedDifference, leftOnly, rightOnly);
+	}
+
+	/*
+		Exact set equality, duplicates are ignored. Takes one linear merge
+		pass if both containers are sorted, otherwise sorts copies of them.
+	*/
+	bool CompareExact() const {
+		if (this->isLeftSorted && this->isRightSorted) {
+			auto stop = [](const ValueType &) { return false; };
+			return this->MergeDifference(stop, stop);
+		}
+		vector<ValueType> left(leftContainer.begin(), leftContainer.end());
+		vector<ValueType> right(rightContainer.begin(), rightContainer.end());
+		return IsSameSetBySorting(left, right);
+	}
+
+	/*
+		Appends every distinct element only in the left set to leftOnly, and
+		every one only in the right set to rightOnly, both in ascending order.
+		Returns whether the sets are equal. Unsorted containers are sorted
+		into copies first, which takes O(n log n) time.
+	*/
+	template<typename OutputContainer>
+	bool GetDifference(OutputContainer &leftOnly, OutputContainer &rightOnly) const {
+		auto toLeft = [&](const ValueType &value) { leftOnly.push_back(value); return true; };
+		auto toRight = [&](const ValueType &value) { rightOnly.push_back(value); return true; };
+		if (this->isLeftSorted && this->isRightSorted)return this->MergeDifference(toLeft, toRight);
+
+		vector<ValueType> left(leftContainer.begin(), leftContainer.end());
+		vector<ValueType> right(rightContainer.begin(), rightContainer.end());
+		sort(left.begin(), left.end());
+		sort(right.begin(), right.end());
+		return MergeDifference(left, right, toLeft, toRight);
+	}
 private:
+	bool IsInLeft(const ValueType &value) const {
+		return Contains(leftContainer, value, this->isLeftSorted, IsLessComparable<ValueType>{});
+	}
+
+	bool IsInRight(const ValueType &value) const {
+		return Contains(rightContainer, value, this->isRightSorted, IsLessComparable<ValueType>{});
+	}
+
+	template<typename Container>
+	static bool Contains(const Container &container, const ValueType &value, bool isSorted, true_type) {
+		if (!isSorted)return find(container.begin(), container.end(), value) != container.end();
+		auto index = BranchlessLowerBound(container, 0, container.size(), value);
+		return index < container.size() && !(value < container[index]);
+	}
+
+	template<typename Container>
+	static bool Contains(const Container &container, const ValueType &value, bool, false_type) {
+		return find(container.begin(), container.end(), value) != container.end();
+	}
+
+	template<typename Container>
+	static bool DetectSortedness(const Container &container, true_type) {
+		return is_sorted(container.begin(), container.end());
+	}
+
+	template<typename Container>
+	static bool DetectSortedness(const Container &, false_type) {
+		return false;
+	}
+
+	/*
+		The first index in [begin, end) whose element is not less than value.
+		The loop always runs log2(n) times and only moves the base with a
+		conditional, which compiles to a conditional move instead of a
+		hard-to-predict branch.
+	*/
+	template<typename Container>
+	static size_t BranchlessLowerBound(const Container &container, size_t begin, size_t end, const ValueType &value) {
+		auto length = end - begin;
+		if (length == 0)return begin;
+		auto base = begin;
+		while (length > 1) {
+			auto half = length / 2;
+			base = (container[base + half - 1] < value) ? base + half : base;
+			length -= half;
+		}
+		return base + (container[base] < value ? 1 : 0);
+	}
+
+	/*
+		The first index in [begin, end) whose element is not less than value,
+		found by doubling the step from begin and then searching the last
+		step. It takes O(log d) time where d is the distance to the result,
+		so the merge skips long runs missing from the other set quickly.
+	*/
+	template<typename Container>
+	static size_t GallopLowerBound(const Container &container, size_t begin, size_t end, const ValueType &value) {
+		size_t step = 1;
+		auto low = begin;
+		while (low + step < end && container[low + step] < value) {
+			low += step;
+			step *= 2;
+		}
+		return BranchlessLowerBound(container, low, min(low + step, end), value);
+	}
+
+	template<typename LeftOutput, typename RightOutput>
+	bool MergeDifference(LeftOutput &toLeft, RightOutput &toRight) const {
+		return MergeDifference(leftContainer, rightContainer, toLeft, toRight);
+	}
+
+	/*
+		Merges two sorted containers and passes every distinct element missing
+		from the other side to the matching callback. A callback returns false
+		to stop the merge early. Returns whether no such element was found.
+	*/
+	template<typename LeftSorted, typename RightSorted, typename LeftOutput, typename RightOutput>
+	static bool MergeDifference(const LeftSorted &left, const RightSorted &right,
+		LeftOutput &toLeft, RightOutput &toRight) {
+		bool isSame = true;
+		size_t i = 0, j = 0;
+		auto leftSize = left.size(), rightSize = right.size();
+
+		// passes the distinct elements in [begin, end) to the output
+		auto emitRun = [&isSame](const auto &container, size_t begin, size_t end, auto &output) {
+			for (auto k = begin; k < end; ++k) {
+				if (k > begin && !(container[k - 1] < container[k]))continue;
+				isSame = false;
+				if (!output(container[k]))return false;
+			}
+			return true;
+		};
+
+		while (i < leftSize && j < rightSize) {
+			if (left[i] < right[j]) {
+				auto next = GallopLowerBound(left, i, leftSize, right[j]);
+				if (!emitRun(left, i, next, toLeft))return false;
+				i = next;
+			}
+			else if (right[j] < left[i]) {
+				auto next = GallopLowerBound(right, j, rightSize, left[i]);
+				if (!emitRun(right, j, next, toRight))return false;
+				j = next;
+			}
+			else {
+				// skip the element and its duplicates on both sides
+				const auto &value = left[i];
+				while (i < leftSize && !(value < left[i]))++i;
+				while (j < rightSize && !(value < right[j]))++j;
+			}
+		}
+		if (!emitRun(left, i, leftSize, toLeft))return false;
+		if (!emitRun(right, j, rightSize, toRight))return false;
+		return isSame;
+	}
+
+	static void FillMismatch(CompareReport &report, bool isLeft, size_t index, const ValueType &value) {
+		report.isSame = false;
+		report.isLeftMismatch = isLeft;
+		report.mismatchIndex = index;
+		report.value = value;
+	}
+
 	RandomEngine randomEngine;
 	const LeftContainerType &leftContainer;
 	const RightContainerType &rightContainer;
-	DistributionPtrType distribution;
+	SizeMode sizeMode;
+	bool isLeftSorted{ false };
+	bool isRightSorted{ false };
+	DistributionType leftDistribution;
+	DistributionType rightDistribution;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,197 @@
+#ifndef DEF_SETRECONCILIATION_HPP
+#define DEF_SETRECONCILIATION_HPP
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../Common/ParallelRandom.hpp"
+
+using namespace std;
+
+/*
+	Invertible Bloom lookup table (IBLT) for set reconciliation.
+
+	Every element is added to one cell in each of the numOfHashes subtables.
+	A cell keeps the number of elements in it, the XOR of the elements
+	and the XOR of their check hashes. Encoding both sets with the same
+	seed and subtracting one table from the other cancels all common
+	elements, leaving only the symmetric difference, which can be recovered
+	by repeatedly "peeling" pure cells (cells holding exactly one element).
+
+	The table needs about 1.5 cells per differing element no matter how large
+	the sets are, and decoding the difference takes O(n + d) time in total.
+	The value type should be an integral or enum type of at most 8 bytes,
+	and every element should appear at most once in each set.
+*/
+template<typename ValueType>
+class InvertibleBloomLookupTable {
+public:
+	static_assert(is_integral<ValueType>::value || is_enum<ValueType>::value,
+		"the value type should be an integral or enum type");
+	static_assert(sizeof(ValueType) <= sizeof(uint64_t), "the value type should be at most 64 bits");
+
+	static constexpr size_t numOfHashes = 3;
+
+	struct Cell {
+		int64_t count = 0;
+		uint64_t keySum = 0;
+		uint64_t hashSum = 0;
+	};
+
+	// the seed should be the same for the tables that are going to be subtracted
+	InvertibleBloomLookupTable(size_t expectedDifference, uint64_t seed) :seed{ seed } {
+		// 1.5 cells per element is comfortably above the peeling threshold
+		// of 1.23 for three hash functions, small tables need some slack
+		size_t numOfCells = expectedDifference + expectedDifference / 2 + 3 * numOfHashes;
+		this->subtableSize = (numOfCells + numOfHashes - 1) / numOfHashes;
+		this->cells.resize(this->subtableSize * numOfHashes);
+	}
+
+	void Insert(const ValueType &value) { this->Update(ToKey(value), 1); }
+	void Erase(const ValueType &value) { this->Update(ToKey(value), -1); }
+
+	template<typename Container>
+	void InsertAll(const Container &container) {
+		for (const auto &value : container)this->Update(ToKey(value), 1);
+	}
+
+	template<typename Container>
+	void EraseAll(const Container &container) {
+		for (const auto &value : container)this->Update(ToKey(value), -1);
+	}
+
+	// cell-wise subtraction, both tables should have the same size and seed
+	void Subtract(const InvertibleBloomLookupTable &other) {
+		if (this->cells.size() != other.cells.size() || this->seed != other.seed)
+			throw runtime_error{ "the tables are not compatible" };
+		for (size_t i = 0; i < this->cells.size(); ++i) {
+			this->cells[i].count -= other.cells[i].count;
+			this->cells[i].keySum ^= other.cells[i].keySum;
+			this->cells[i].hashSum ^= other.cells[i].hashSum;
+		}
+	}
+
+	/*
+		Peels the table, which is destroyed in the process. Elements with positive
+		count (only in the minuend) are appended to leftOnly, those with
+		negative count to rightOnly. Returns false if the table could not be
+		fully decoded, which happens when the actual difference is much larger
+		than the expected one. In that case the outputs are incomplete.
+	*/
+	template<typename OutputContainer>
+	bool Decode(OutputContainer &leftOnly, OutputContainer &rightOnly) {
+		this->pending.clear();
+		this->pending.reserve(this->cells.size() * 2);
+		for (size_t i = 0; i < this->cells.size(); ++i) {
+			if (this->IsPure(this->cells[i]))this->pending.push_back(i);
+		}
+
+		while (!this->pending.empty()) {
+			auto index = this->pending.back();
+			this->pending.pop_back();
+
+			// the cell might have changed since it was pushed
+			const auto cell = this->cells[index];
+			if (!this->IsPure(cell))continue;
+
+			if (cell.count > 0)leftOnly.push_back(FromKey(cell.keySum));
+			else rightOnly.push_back(FromKey(cell.keySum));
+
+			// remove the element from all of its cells
+			for (size_t i = 0; i < numOfHashes; ++i) {
+				auto &target = this->cells[this->GetCellIndex(cell.keySum, i)];
+				target.count -= cell.count;
+				target.keySum ^= cell.keySum;
+				target.hashSum ^= cell.hashSum;
+				if (this->IsPure(target))this->pending.push_back(&target - this->cells.data());
+			}
+		}
+
+		for (const auto &cell : this->cells) {
+			if (cell.count != 0 || cell.keySum != 0 || cell.hashSum != 0)return false;
+		}
+		return true;
+	}
+
+	size_t GetNumOfCells() const { return this->cells.size(); }
+
+private:
+	static uint64_t ToKey(const ValueType &value) {
+		uint64_t key = 0;
+		memcpy(&key, &value, sizeof(ValueType));
+		return key;
+	}
+
+	static ValueType FromKey(uint64_t key) {
+		ValueType value;
+		memcpy(&value, &key, sizeof(ValueType));
+		return value;
+	}
+
+	// the splitmix64 finalizer
+	static uint64_t Mix(uint64_t x) {
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	uint64_t GetCheckHash(uint64_t key) const {
+		return Mix(key ^ this->seed);
+	}
+
+	size_t GetCellIndex(uint64_t key, size_t hashIndex) const {
+		auto h = Mix(key + this->seed * (hashIndex + 1) + hashIndex);
+		return hashIndex * this->subtableSize + (size_t)(h % this->subtableSize);
+	}
+
+	bool IsPure(const Cell &cell) const {
+		return (cell.count == 1 || cell.count == -1) && cell.hashSum == this->GetCheckHash(cell.keySum);
+	}
+
+	void Update(uint64_t key, int64_t delta) {
+		auto checkHash = this->GetCheckHash(key);
+		for (size_t i = 0; i < numOfHashes; ++i) {
+			auto &cell = this->cells[this->GetCellIndex(key, i)];
+			cell.count += delta;
+			cell.keySum ^= key;
+			cell.hashSum ^= checkHash;
+		}
+	}
+
+	uint64_t seed;
+	size_t subtableSize;
+	vector<Cell> cells;
+	// candidate pure cells, kept as a member to be reused across decodings
+	vector<size_t> pending;
+};
+
+/*
+	Computes the symmetric difference of two sets with an IBLT. The outputs
+	receive the elements only in left and only in right respectively.
+	Returns false if the difference turns out to be too large for
+	expectedDifference; the caller may retry with a larger estimate.
+*/
+template<typename LeftCType, typename RightCType, typename OutputContainer>
+bool ReconcileSets(const LeftCType &left, const RightCType &right, size_t expectedDifference,
+	OutputContainer &leftOnly, OutputContainer &rightOnly) {
+	using TableType = InvertibleBloomLookupTable<typename LeftCType::value_type>;
+
+	// use the time now as the random seed
+	Xoshiro256StarStar randomEngine{ (uint64_t)chrono::system_clock::now().time_since_epoch().count() };
+	auto seed = randomEngine();
+	// inserting one side and erasing the other is the same as
+	// encoding both and subtracting, but only needs one table
+	TableType table{ expectedDifference, seed };
+	table.InsertAll(left);
+	table.EraseAll(right);
+
+	leftOnly.reserve(leftOnly.size() + expectedDifference);
+	rightOnly.reserve(rightOnly.size() + expectedDifference);
+	return table.Decode(leftOnly, rightOnly);
+}
+
+#endif
@@ -0,0 +1,402 @@
+#ifndef DEF_SETSKETCH_HPP
+#define DEF_SETSKETCH_HPP
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+/*
+	Small, mergeable summaries of huge sets, which tell how different two
+	sets are without touching the sets again:
+	- MinHashSketch estimates the Jaccard similarity |A & B| / |A | B|;
+	- HyperLogLogSketch estimates the number of distinct elements;
+	- SetSketch holds both and combines them into SimilarityEstimate.
+	Sketches can only be merged or compared if they have the same
+	parameters and seed. All of them serialize into a byte vector
+	with a fixed little-endian layout.
+*/
+
+namespace SketchDetail {
+	// the splitmix64 finalizer
+	inline uint64_t Mix(uint64_t x) {
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	// x should not be zero
+	inline int CountLeadingZeros(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanReverse64(&index, x);
+		return 63 - (int)index;
+#elif defined(__GNUC__)
+		return __builtin_clzll(x);
+#else
+		int count = 0;
+		while (!(x & (uint64_t(1) << 63))) {
+			x <<= 1;
+			++count;
+		}
+		return count;
+#endif
+	}
+
+	inline void AppendUint64(vector<uint8_t> &output, uint64_t value) {
+		for (int i = 0; i < 8; ++i)output.push_back((uint8_t)(value >> (8 * i)));
+	}
+
+	inline uint64_t ReadUint64(const uint8_t *&input, const uint8_t *end) {
+		if (end - input < 8)throw runtime_error{ "the sketch data is truncated" };
+		uint64_t value = 0;
+		for (int i = 0; i < 8; ++i)value |= (uint64_t)input[i] << (8 * i);
+		input += 8;
+		return value;
+	}
+
+	// the elements are hashed in blocks of this size, so that the hashing
+	// loop has no dependency on the sketch state and can be vectorized
+	constexpr size_t hashBlockSize = 64;
+
+	constexpr uint64_t minHashMagic = 0x48534e494d534b53ULL;
+	constexpr uint64_t hyperLogLogMagic = 0x4c4c48534b535453ULL;
+}
+
+/*
+	One-permutation MinHash: every element is hashed once, the hash picks
+	one of numOfBins bins and the bin keeps the minimum hash it has seen.
+	Bins that stay empty (common for small sets) are filled by optimal
+	densification, i.e. each empty bin borrows the value of a non-empty bin
+	chosen by a hash sequence of its own index, so that both sketches borrow
+	from the same bins. The fraction of equal bins estimates the Jaccard
+	similarity with a standard error of about 1 / sqrt(numOfBins).
+*/
+template<typename ValueType, typename Hasher = hash<ValueType>>
+class MinHashSketch {
+public:
+	static constexpr uint64_t emptyBin = numeric_limits<uint64_t>::max();
+
+	MinHashSketch(size_t numOfBins = 256, uint64_t _seed = 0) :seed{ _seed } {
+		if (numOfBins == 0)throw runtime_error{ "there should be at least one bin" };
+		this->bins.assign(numOfBins, numeric_limits<uint64_t>::max());
+	}
+
+	void Insert(const ValueType &value) {
+		this->InsertHash(SketchDetail::Mix((uint64_t)this->hasher(value) ^ this->seed));
+	}
+
+	template<typename Iter>
+	void InsertRange(Iter begin, Iter end) {
+		uint64_t hashes[SketchDetail::hashBlockSize];
+		while (begin != end) {
+			size_t filled = 0;
+			for (; begin != end && filled < SketchDetail::hashBlockSize; ++begin) {
+				hashes[filled++] = (uint64_t)this->hasher(*begin);
+			}
+			for (size_t i = 0; i < filled; ++i)hashes[i] = SketchDetail::Mix(hashes[i] ^ this->seed);
+			for (size_t i = 0; i < filled; ++i)this->InsertHash(hashes[i]);
+		}
+	}
+
+	template<typename Container>
+	void InsertAll(const Container &container) {
+		this->InsertRange(container.begin(), container.end());
+	}
+
+	// the sketch of the union of both sets
+	void Merge(const MinHashSketch &other) {
+		this->CheckCompatible(other);
+		for (size_t i = 0; i < this->bins.size(); ++i) {
+			this->bins[i] = min(this->bins[i], other.bins[i]);
+		}
+	}
+
+	bool IsEmpty() const {
+		return all_of(this->bins.begin(), this->bins.end(), [](uint64_t bin) { return bin == emptyBin; });
+	}
+
+	// the bins after densification, empty if the set is empty
+	vector<uint64_t> GetSignature() const {
+		vector<uint64_t> signature{ this->bins };
+		if (this->IsEmpty())return vector<uint64_t>{};
+
+		auto numOfBins = (uint64_t)this->bins.size();
+		for (uint64_t i = 0; i < numOfBins; ++i) {
+			if (this->bins[i] != emptyBin)continue;
+			// the sequence only depends on the bin index and the seed
+			uint64_t state = SketchDetail::Mix(i ^ this->seed);
+			while (true) {
+				state = SketchDetail::Mix(state + 0x9e3779b97f4a7c15ULL);
+				auto donor = state % numOfBins;
+				if (this->bins[donor] != emptyBin) {
+					signature[i] = this->bins[donor];
+					break;
+				}
+			}
+		}
+		return signature;
+	}
+
+	double EstimateJaccard(const MinHashSketch &other) const {
+		this->CheckCompatible(other);
+		auto left = this->GetSignature();
+		auto right = other.GetSignature();
+		if (left.empty() || right.empty())return (left.empty() && right.empty()) ? 1.0 : 0.0;
+
+		size_t numOfEqual = 0;
+		for (size_t i = 0; i < left.size(); ++i)numOfEqual += (left[i] == right[i]) ? 1 : 0;
+		return (double)numOfEqual / (double)left.size();
+	}
+
+	size_t GetNumOfBins() const { return this->bins.size(); }
+	uint64_t GetSeed() const { return this->seed; }
+
+	void Serialize(vector<uint8_t> &output) const {
+		SketchDetail::AppendUint64(output, SketchDetail::minHashMagic);
+		SketchDetail::AppendUint64(output, this->seed);
+		SketchDetail::AppendUint64(output, this->bins.size());
+		for (auto bin : this->bins)SketchDetail::AppendUint64(output, bin);
+	}
+
+	// reads a sketch and moves input past it
+	static MinHashSketch Deserialize(const uint8_t *&input, const uint8_t *end) {
+		if (SketchDetail::ReadUint64(input, end) != SketchDetail::minHashMagic)
+			throw runtime_error{ "the data is not a MinHash sketch" };
+		auto seed = SketchDetail::ReadUint64(input, end);
+		auto numOfBins = SketchDetail::ReadUint64(input, end);
+		if (numOfBins == 0 || numOfBins > (uint64_t)(end - input) / 8)
+			throw runtime_error{ "the sketch data is truncated" };
+		MinHashSketch result{ (size_t)numOfBins, seed };
+		for (auto &bin : result.bins)bin = SketchDetail::ReadUint64(input, end);
+		return result;
+	}
+
+	// inserts an element by its hash, which should be Mix(hasher(value) ^ seed)
+	void InsertHash(uint64_t h) {
+		auto index = (size_t)(h % this->bins.size());
+		// rehash, so that the value is independent of the bin index
+		auto value = SketchDetail::Mix(h ^ 0x5851f42d4c957f2dULL);
+		if (value < this->bins[index])this->bins[index] = value;
+	}
+
+private:
+	void CheckCompatible(const MinHashSketch &other) const {
+		if (this->seed != other.seed || this->bins.size() != other.bins.size())
+			throw runtime_error{ "the sketches are not compatible" };
+	}
+
+	Hasher hasher;
+	uint64_t seed;
+	vector<uint64_t> bins;
+};
+
+/*
+	HyperLogLog with 2^precision registers of one byte each. Every hash picks
+	a register with its top bits and stores the position of the first one bit
+	in the remaining bits. The cardinality estimate has a standard error of
+	about 1.04 / sqrt(2^precision); linear counting is used for small sets.
+*/
+template<typename ValueType, typename Hasher = hash<ValueType>>
+class HyperLogLogSketch {
+public:
+	HyperLogLogSketch(int _precision = 12, uint64_t _seed = 0) :precision{ _precision }, seed{ _seed } {
+		if (this->precision < 4 || this->precision > 18)throw runtime_error{ "the precision should be in [4, 18]" };
+		this->registers.assign(size_t(1) << this->precision, 0);
+	}
+
+	void Insert(const ValueType &value) {
+		this->InsertHash(SketchDetail::Mix((uint64_t)this->hasher(value) ^ this->seed));
+	}
+
+	template<typename Iter>
+	void InsertRange(Iter begin, Iter end) {
+		uint64_t hashes[SketchDetail::hashBlockSize];
+		while (begin != end) {
+			size_t filled = 0;
+			for (; begin != end && filled < SketchDetail::hashBlockSize; ++begin) {
+				hashes[filled++] = (uint64_t)this->hasher(*begin);
+			}
+			for (size_t i = 0; i < filled; ++i)hashes[i] = SketchDetail::Mix(hashes[i] ^ this->seed);
+			for (size_t i = 0; i < filled; ++i)this->InsertHash(hashes[i]);
+		}
+	}
+
+	template<typename Container>
+	void InsertAll(const Container &container) {
+		this->InsertRange(container.begin(), container.end());
+	}
+
+	// the sketch of the union of both sets
+	void Merge(const HyperLogLogSketch &other) {
+		this->CheckCompatible(other);
+		for (size_t i = 0; i < this->registers.size(); ++i) {
+			this->registers[i] = max(this->registers[i], other.registers[i]);
+		}
+	}
+
+	double EstimateCardinality() const {
+		auto m = (double)this->registers.size();
+		double sum = 0.0;
+		size_t numOfZeros = 0;
+		for (auto reg : this->registers) {
+			sum += ldexp(1.0, -(int)reg);
+			numOfZeros += (reg == 0) ? 1 : 0;
+		}
+
+		double alpha = 0.7213 / (1.0 + 1.079 / m);
+		double estimate = alpha * m * m / sum;
+		if (estimate <= 2.5 * m && numOfZeros > 0) {
+			estimate = m * log(m / (double)numOfZeros);
+		}
+		return estimate;
+	}
+
+	int GetPrecision() const { return this->precision; }
+	uint64_t GetSeed() const { return this->seed; }
+
+	void Serialize(vector<uint8_t> &output) const {
+		SketchDetail::AppendUint64(output, SketchDetail::hyperLogLogMagic);
+		SketchDetail::AppendUint64(output, this->seed);
+		SketchDetail::AppendUint64(output, (uint64_t)this->precision);
+		output.insert(output.end(), this->registers.begin(), this->registers.end());
+	}
+
+	// reads a sketch and moves input past it
+	static HyperLogLogSketch Deserialize(const uint8_t *&input, const uint8_t *end) {
+		if (SketchDetail::ReadUint64(input, end) != SketchDetail::hyperLogLogMagic)
+			throw runtime_error{ "the data is not a HyperLogLog sketch" };
+		auto seed = SketchDetail::ReadUint64(input, end);
+		auto precision = SketchDetail::ReadUint64(input, end);
+		if (precision < 4 || precision > 18)throw runtime_error{ "the sketch data is corrupted" };
+		HyperLogLogSketch result{ (int)precision, seed };
+		if ((size_t)(end - input) < result.registers.size())throw runtime_error{ "the sketch data is truncated" };
+		copy(input, input + result.registers.size(), result.registers.begin());
+		input += result.registers.size();
+		return result;
+	}
+
+	// inserts an element by its hash, which should be Mix(hasher(value) ^ seed)
+	void InsertHash(uint64_t h) {
+		auto index = (size_t)(h >> (64 - this->precision));
+		// the sentinel bit keeps the rank within 64 - precision + 1
+		auto rest = (h << this->precision) | (uint64_t(1) << (this->precision - 1));
+		auto rank = (uint8_t)(SketchDetail::CountLeadingZeros(rest) + 1);
+		if (rank > this->registers[index])this->registers[index] = rank;
+	}
+
+private:
+	void CheckCompatible(const HyperLogLogSketch &other) const {
+		if (this->seed != other.seed || this->precision != other.precision)
+			throw runtime_error{ "the sketches are not compatible" };
+	}
+
+	Hasher hasher;
+	int precision;
+	uint64_t seed;
+	vector<uint8_t> registers;
+};
+
+struct SimilarityEstimate {
+	double jaccard;
+	double leftCardinality;
+	double rightCardinality;
+	double unionCardinality;
+	double intersectionCardinality;
+	// estimated size of the symmetric difference
+	double differenceCardinality;
+};
+
+// MinHash and HyperLogLog of one set, filled in the same pass
+template<typename ValueType, typename Hasher = hash<ValueType>>
+class SetSketch {
+public:
+	using MinHashType = MinHashSketch<ValueType, Hasher>;
+	using HyperLogLogType = HyperLogLogSketch<ValueType, Hasher>;
+
+	SetSketch(size_t numOfBins = 256, int precision = 12, uint64_t seed = 0) :
+		minHash{ numOfBins, seed }, hyperLogLog{ precision, seed } {}
+
+	void Insert(const ValueType &value) {
+		this->minHash.Insert(value);
+		this->hyperLogLog.Insert(value);
+	}
+
+	// hashes every element once and feeds the hash to both sketches
+	template<typename Iter>
+	void InsertRange(Iter begin, Iter end) {
+		uint64_t hashes[SketchDetail::hashBlockSize];
+		auto seed = this->minHash.GetSeed();
+		while (begin != end) {
+			size_t filled = 0;
+			for (; begin != end && filled < SketchDetail::hashBlockSize; ++begin) {
+				hashes[filled++] = (uint64_t)this->hasher(*begin);
+			}
+			for (size_t i = 0; i < filled; ++i)hashes[i] = SketchDetail::Mix(hashes[i] ^ seed);
+			for (size_t i = 0; i < filled; ++i) {
+				this->minHash.InsertHash(hashes[i]);
+				this->hyperLogLog.InsertHash(hashes[i]);
+			}
+		}
+	}
+
+	template<typename Container>
+	void InsertAll(const Container &container) {
+		this->InsertRange(container.begin(), container.end());
+	}
+
+	void Merge(const SetSketch &other) {
+		this->minHash.Merge(other.minHash);
+		this->hyperLogLog.Merge(other.hyperLogLog);
+	}
+
+	const MinHashType &GetMinHash() const { return this->minHash; }
+	const HyperLogLogType &GetHyperLogLog() const { return this->hyperLogLog; }
+
+	SimilarityEstimate Compare(const SetSketch &other) const {
+		SimilarityEstimate result;
+		result.jaccard = this->minHash.EstimateJaccard(other.minHash);
+		result.leftCardinality = this->hyperLogLog.EstimateCardinality();
+		result.rightCardinality = other.hyperLogLog.EstimateCardinality();
+
+		auto unionSketch = this->hyperLogLog;
+		unionSketch.Merge(other.hyperLogLog);
+		result.unionCardinality = unionSketch.EstimateCardinality();
+		result.intersectionCardinality = result.jaccard * result.unionCardinality;
+		result.differenceCardinality = result.unionCardinality - result.intersectionCardinality;
+		return result;
+	}
+
+	vector<uint8_t> Serialize() const {
+		vector<uint8_t> output;
+		this->minHash.Serialize(output);
+		this->hyperLogLog.Serialize(output);
+		return output;
+	}
+
+	static SetSketch Deserialize(const vector<uint8_t> &data) {
+		const uint8_t *input = data.data();
+		const uint8_t *end = data.data() + data.size();
+		SetSketch result;
+		result.minHash = MinHashType::Deserialize(input, end);
+		result.hyperLogLog = HyperLogLogType::Deserialize(input, end);
+		return result;
+	}
+
+private:
+	Hasher hasher;
+	MinHashType minHash;
+	HyperLogLogType hyperLogLog;
+};
+
+#endif
@@ -1,9 +1,17 @@
 #include "SetComparison.hpp"
+#include "MultisetFingerprint.hpp"
+#include "BatchSetComparison.hpp"
+#include "FileSetComparison.hpp"
+#include "SetSketch.hpp"
 
 #include <vector>
 #include <iostream>
 #include <stdlib.h>
 #include <set>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
 
 using namespace std;
 
@@ -30,6 +38,14 @@ const int numOfTest = 100;
 const int numOfComparisonLow = 6;
 const int numOfComparisonHigh = 13;
 
+template<typename Container>
+void WriteArray(const string &path, const Container &container) {
+	FILE *file = fopen(path.c_str(), "wb");
+	if (file == nullptr)throw runtime_error{ "cannot create " + path };
+	fwrite(container.data(), sizeof(typename Container::value_type), container.size(), file);
+	fclose(file);
+}
+
 template<typename Container>
 void ShowArray(const Container &container) {
 	for (const auto &ele : container) {
@@ -73,6 +89,19 @@ int main() {
 		isSTSame[i] = isSame;
 	}
 
+	// fingerprints take one pass over each set instead of copying and sorting
+	// them, and should agree with the exact check
+	cout << "-----------------------------------\n";
+	cout << "Multiset fingerprints, false positive rate " << MultisetFingerprint<char>::GetFalsePositiveBound() << "\n";
+	for (auto i = 0; i < 3; ++i) {
+		bool isFingerprintSame = IsMultisetEqual(SSets[i], TSets[i]);
+		cout << "Test case " << i + 1 << ": exact " << (isSTSame[i] ? "equal" : "not equal");
+		cout << " | fingerprint " << (isFingerprintSame ? "equal" : "not equal") << "\n";
+		if (isFingerprintSame != isSTSame[i])
+			throw runtime_error{ "the fingerprint disagrees with the exact check" };
+	}
+	cout << "-----------------------------------\n\n\n";
+
 	for (auto numOfComparison = numOfComparisonLow; numOfComparison < numOfComparisonHigh; ++numOfComparison) {
 
 		cout << "-----------------------------------\n";
@@ -120,6 +149,26 @@ int main() {
 			}
 
 			cout << "\n";
+
+			// the table is sized by the difference found above, not by the sets
+			vector<TestContainerType::value_type> leftOnly, rightOnly;
+			if (setComparison.ReconcileDifference(difference.size(), leftOnly, rightOnly)) {
+				sort(leftOnly.begin(), leftOnly.end());
+				sort(rightOnly.begin(), rightOnly.end());
+				cout << "Reconciled difference (S only | T only): ";
+				ShowArray(leftOnly);
+				cout << "                                        | ";
+				ShowArray(rightOnly);
+
+				vector<TestContainerType::value_type> exactLeftOnly, exactRightOnly;
+				setComparison.GetDifference(exactLeftOnly, exactRightOnly);
+				if (leftOnly != exactLeftOnly || rightOnly != exactRightOnly)
+					throw runtime_error{ "the reconciled difference is wrong" };
+			}
+			else {
+				cout << "Reconciliation with a table for " << difference.size() << " elements failed to decode\n";
+			}
+
 			cout << "Equal counter: " << equalCounter << " | Not equal counter: " << notEqualCounter;
 			cout << " | Success rate: ";
 			if (isSTSame[i]) {
@@ -134,6 +183,165 @@ int main() {
 		cout << "-----------------------------------\n\n\n";
 	}
 
+	// let the comparison decide how many trials are needed
+	const double maxFalsePositiveRate = 0.001;
+	cout << "-----------------------------------\n";
+	cout << "Comparing with a false positive rate of at most " << maxFalsePositiveRate << "\n";
+	for (auto i = 0; i < 3; ++i) {
+		SetComparison<TestContainerType, TestContainerType> setComparison{ SSets[i], TSets[i] };
+		auto report = setComparison.Compare(maxFalsePositiveRate);
+		cout << "Test case " << i + 1 << ": " << (report.isSame ? "equal" : "not equal");
+		cout << " after " << report.numOfTrials << " of ";
+		cout << setComparison.GetNumOfTrials(maxFalsePositiveRate) << " trials";
+		if (!report.isSame) {
+			cout << ", " << report.value << " at index " << report.mismatchIndex;
+			cout << " of " << (report.isLeftMismatch ? "S" : "T") << " is missing from the other set";
+		}
+		cout << "\n";
+
+		// the same number of trials with one pass over each set
+		auto batchedReport = setComparison.CompareBatched(setComparison.GetNumOfTrials(maxFalsePositiveRate));
+		size_t numOfFound = 0;
+		for (size_t j = 0; j < batchedReport.numOfProbes; ++j) {
+			numOfFound += ((batchedReport.leftFound >> j) & 1) + ((batchedReport.rightFound >> j) & 1);
+		}
+		cout << "    batched probes: " << (batchedReport.isSame ? "equal" : "not equal") << ", ";
+		cout << numOfFound << " of " << 2 * batchedReport.numOfProbes << " probes found\n";
+
+		// sorted sets are compared exactly with one merge pass
+		TestContainerType sortedS{ SSets[i] }, sortedT{ TSets[i] };
+		sort(sortedS.begin(), sortedS.end());
+		sort(sortedT.begin(), sortedT.end());
+		SetComparison<TestContainerType, TestContainerType> sortedComparison{ sortedS, sortedT, SortedInputTag{} };
+		TestContainerType sOnly, tOnly;
+		bool isSame = sortedComparison.GetDifference(sOnly, tOnly);
+		cout << "    exact merge: " << (isSame ? "equal" : "not equal");
+		if (!isSame) {
+			cout << ", S only: ";
+			for (const auto &ele : sOnly)cout << ele << " ";
+			cout << "| T only: ";
+			for (const auto &ele : tOnly)cout << ele << " ";
+		}
+		cout << "\n";
+	}
+	cout << "-----------------------------------\n\n\n";
+
+	// compare all pairs at once, the sets are packed into one storage array
+	TestContainerType storage;
+	vector<SetPairDescriptor> pairs;
+	for (auto i = 0; i < 3; ++i) {
+		SetPairDescriptor pair;
+		pair.leftOffset = storage.size();
+		pair.leftSize = SSets[i].size();
+		storage.insert(storage.end(), SSets[i].begin(), SSets[i].end());
+		pair.rightOffset = storage.size();
+		pair.rightSize = TSets[i].size();
+		storage.insert(storage.end(), TSets[i].begin(), TSets[i].end());
+		pairs.push_back(pair);
+	}
+
+	BatchSetComparison<TestContainerType::value_type> batchComparison;
+	unique_ptr<bool[]> exactVerdicts{ new bool[pairs.size()] };
+	unique_ptr<bool[]> sampledVerdicts{ new bool[pairs.size()] };
+	batchComparison.CompareExact(storage.data(), pairs.data(), pairs.size(), exactVerdicts.get());
+	batchComparison.CompareSampled(storage.data(), pairs.data(), pairs.size(),
+		maxFalsePositiveRate, sampledVerdicts.get());
+
+	cout << "-----------------------------------\n";
+	cout << "Batch comparison with " << batchComparison.GetNumOfThreads() << " threads\n";
+	for (size_t i = 0; i < pairs.size(); ++i) {
+		cout << "Test case " << i + 1 << ": exact " << (exactVerdicts[i] ? "equal" : "not equal");
+		cout << " | sampled " << (sampledVerdicts[i] ? "equal" : "not equal") << "\n";
+	}
+	cout << "-----------------------------------\n\n\n";
+
+	// sets in files, with a memory budget of 4KB so that the exact verdict
+	// partitions them over several passes, and a value repeated many times
+	// on the left side to make one bucket far larger than the others
+	const size_t numOfFileElements = 20000;
+	const size_t fileMemoryBudget = 4096;
+	vector<uint32_t> leftValues;
+	for (uint32_t i = 0; i < numOfFileElements; ++i)leftValues.push_back(i);
+	leftValues.insert(leftValues.end(), 5000, 7);
+	vector<uint32_t> sameValues{ leftValues.rbegin() + 4997, leftValues.rend() };
+	vector<uint32_t> changedValues{ sameValues };
+	changedValues[0] = 123456789;
+	vector<uint32_t> fewerValues{ sameValues };
+	fewerValues.erase(find(fewerValues.begin(), fewerValues.end(), 42));
+
+	const vector<vector<uint32_t>> rightValues{ sameValues, changedValues, fewerValues };
+	const bool isFileSame[] = { true, false, false };
+	WriteArray("left.bin", leftValues);
+	cout << "-----------------------------------\n";
+	cout << "Comparing files of " << numOfFileElements << " distinct elements with a budget of " << fileMemoryBudget << " bytes\n";
+	for (size_t i = 0; i < rightValues.size(); ++i) {
+		WriteArray("right.bin", rightValues[i]);
+		FileSetComparison<uint32_t> fileComparison{ "left.bin", "right.bin", fileMemoryBudget };
+		bool isExactSame = fileComparison.CompareExact();
+		auto report = fileComparison.CompareSampled(maxFalsePositiveRate);
+		cout << "Test case " << i + 1 << ": exact " << (isExactSame ? "equal" : "not equal");
+		cout << " | sampled " << (report.isSame ? "equal" : "not equal");
+		cout << " | " << fileComparison.GetNumOfBuckets() << " buckets in the first pass\n";
+		if (isExactSame != isFileSame[i])
+			throw runtime_error{ "the exact file comparison is wrong" };
+	}
+	remove("left.bin");
+	remove("right.bin");
+	cout << "-----------------------------------\n\n\n";
+
+	// sketches of A = [0, 60000) and B = [20000, 80000), whose Jaccard
+	// similarity is 40000 / 80000 = 0.5, checked within four standard errors
+	const size_t numOfBins = 1024;
+	const int precision = 12;
+	const uint64_t sketchSeed = 2017;
+	vector<uint64_t> setA, setB, setAB;
+	for (uint64_t i = 0; i < 80000; ++i) {
+		if (i < 60000)setA.push_back(i);
+		if (i >= 20000)setB.push_back(i);
+		setAB.push_back(i);
+	}
+	using SketchType = SetSketch<uint64_t>;
+	SketchType sketchA{ numOfBins, precision, sketchSeed }, sketchB{ numOfBins, precision, sketchSeed };
+	SketchType sketchAB{ numOfBins, precision, sketchSeed };
+	sketchA.InsertAll(setA);
+	sketchB.InsertAll(setB);
+	sketchAB.InsertAll(setAB);
+
+	auto estimate = sketchA.Compare(sketchB);
+	auto jaccardError = 4.0 * sqrt(0.5 * 0.5 / (double)numOfBins);
+	auto cardinalityError = 4.0 * 1.04 / sqrt((double)(size_t(1) << precision));
+	cout << "-----------------------------------\n";
+	cout << "Sketches of A = [0, 60000) and B = [20000, 80000)\n";
+	cout << "Jaccard similarity: " << estimate.jaccard << " (exact 0.5)\n";
+	cout << "|A|: " << estimate.leftCardinality << ", |B|: " << estimate.rightCardinality;
+	cout << ", |A | B|: " << estimate.unionCardinality << " (exact 60000, 60000, 80000)\n";
+	cout << "Symmetric difference: " << estimate.differenceCardinality << " (exact 40000)\n";
+	if (fabs(estimate.jaccard - 0.5) > jaccardError)
+		throw runtime_error{ "the Jaccard estimate is out of range" };
+	if (fabs(estimate.leftCardinality / 60000.0 - 1.0) > cardinalityError
+		|| fabs(estimate.rightCardinality / 60000.0 - 1.0) > cardinalityError
+		|| fabs(estimate.unionCardinality / 80000.0 - 1.0) > cardinalityError)
+		throw runtime_error{ "the cardinality estimate is out of range" };
+
+	// merging keeps the minimum of every bin and the maximum of every
+	// register, so it gives exactly the sketch of the union
+	auto mergedSketch = sketchA;
+	mergedSketch.Merge(sketchB);
+	bool isMergeExact = (mergedSketch.Serialize() == sketchAB.Serialize());
+	cout << "Merged sketch equals the sketch of A | B: " << (isMergeExact ? "yes" : "no") << "\n";
+	if (!isMergeExact)throw runtime_error{ "the merged sketch differs from the sketch of the union" };
+
+	auto serializedSketch = sketchA.Serialize();
+	auto restoredSketch = SketchType::Deserialize(serializedSketch);
+	auto restoredEstimate = restoredSketch.Compare(sketchB);
+	bool isRoundTripExact = (restoredSketch.Serialize() == serializedSketch
+		&& restoredEstimate.jaccard == estimate.jaccard
+		&& restoredEstimate.leftCardinality == estimate.leftCardinality);
+	cout << "Serialized into " << serializedSketch.size() << " bytes, round trip ";
+	cout << (isRoundTripExact ? "exact" : "changed the sketch") << "\n";
+	if (!isRoundTripExact)throw runtime_error{ "the sketch changed in a serialization round trip" };
+	cout << "-----------------------------------\n\n\n";
+
 	system("pause");
 
 	return 0;
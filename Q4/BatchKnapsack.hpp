@@ -0,0 +1,600 @@
+#ifndef DEF_BATCHKNAPSACK_HPP
+#define DEF_BATCHKNAPSACK_HPP
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <string>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <condition_variable>
+
+#include "../Common/MappedFile.hpp"
+#include "Knapsack.hpp"
+
+using namespace std;
+
+/*
+	The binary instance format. All fields are native-endian:
+	- the file header below;
+	- the instances, each one its capacity in an 8-byte slot, then the
+	  weight column and the price column, each padded to a multiple of
+	  8 bytes, so that every column is aligned in a mapped file;
+	- the index at indexOffset, an IndexEntry per instance.
+	The result format is the result header, then for every instance in
+	order its price, its total weight and the algorithm used (each in an
+	8-byte slot), and a bitmap of the chosen items in 64-bit words.
+*/
+namespace KnapsackFileDetail {
+	constexpr uint32_t instanceMagic = 0x3150534b;	// "KSP1"
+	constexpr uint32_t resultMagic = 0x3152534b;	// "KSR1"
+	constexpr uint32_t formatVersion = 1;
+
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t weightSize;
+		uint32_t priceSize;
+		uint64_t numOfInstances;
+		uint64_t indexOffset;
+	};
+
+	struct IndexEntry {
+		uint64_t offset;
+		uint64_t numOfItems;
+	};
+
+	inline uint64_t PadTo8(uint64_t size) {
+		return (size + 7) / 8 * 8;
+	}
+
+	inline uint64_t GetNumOfChoiceWords(uint64_t numOfItems) {
+		return (numOfItems + 63) / 64;
+	}
+
+	// the slots of a result record, which are followed by its choice words
+	constexpr uint64_t resultPriceSlot = 0;
+	constexpr uint64_t resultWeightSlot = 8;
+	constexpr uint64_t resultAlgorithmSlot = 16;
+	constexpr uint64_t resultSlotsSize = 24;
+
+	inline uint64_t GetResultRecordSize(uint64_t numOfItems) {
+		return resultSlotsSize + GetNumOfChoiceWords(numOfItems) * 8;
+	}
+
+	// writes the value into an 8-byte slot padded with zeros
+	template<typename Type>
+	bool WriteSlot(FILE *file, const Type &value) {
+		static_assert(sizeof(Type) <= 8, "the value does not fit in a slot");
+		unsigned char slot[8] = {};
+		memcpy(slot, &value, sizeof(Type));
+		return fwrite(slot, 1, 8, file) == 8;
+	}
+
+	inline bool WritePadding(FILE *file, uint64_t size) {
+		static const unsigned char zeros[8] = {};
+		auto padding = PadTo8(size) - size;
+		return padding == 0 || fwrite(zeros, 1, (size_t)padding, file) == padding;
+	}
+
+	// writes the column padded to a multiple of 8 bytes
+	template<typename Type>
+	bool WriteColumn(FILE *file, const Type *column, size_t size) {
+		if (size == 0)return true;
+		return fwrite(column, sizeof(Type), size, file) == size && WritePadding(file, (uint64_t)size * sizeof(Type));
+	}
+}
+
+// an instance inside a mapped file, the columns point into the mapping
+template<typename WeightT, typename PriceT>
+struct KnapsackInstanceView {
+	WeightT capacity;
+	size_t numOfItems;
+	const WeightT *weights;
+	const PriceT *prices;
+};
+
+// a result inside a mapped result file, the choices point into the mapping
+template<typename WeightT, typename PriceT>
+struct KnapsackResultView {
+	PriceT price;
+	WeightT weight;
+	KnapsackAlgorithm algorithm;
+	size_t numOfItems;
+	const uint64_t *choiceWords;
+
+	bool IsChosen(size_t item) const {
+		return ((this->choiceWords[item / 64] >> (item % 64)) & 1) != 0;
+	}
+};
+
+/*
+	Writes knapsack instances in the binary format. The index is kept in
+	memory and written by Close(), which the destructor also calls.
+*/
+template<typename WeightT, typename PriceT>
+class KnapsackInstanceWriter {
+public:
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+
+	explicit KnapsackInstanceWriter(const string &path) {
+		this->file = fopen(path.c_str(), "wb");
+		if (this->file == nullptr)throw runtime_error{ "cannot create " + path };
+		// the header is written again with the index offset by Close()
+		KnapsackFileDetail::FileHeader header{};
+		if (fwrite(&header, sizeof(header), 1, this->file) != 1)this->Fail();
+		this->offset = sizeof(header);
+	}
+
+	KnapsackInstanceWriter(const KnapsackInstanceWriter &) = delete;
+	KnapsackInstanceWriter &operator=(const KnapsackInstanceWriter &) = delete;
+
+	~KnapsackInstanceWriter() {
+		try {
+			this->Close();
+		}
+		catch (...) {}
+	}
+
+	void Write(WeightType capacity, const WeightType *weights, const PriceType *prices, size_t numOfItems) {
+		using namespace KnapsackFileDetail;
+		if (this->file == nullptr)throw runtime_error{ "the instance file is closed" };
+		auto weightBytes = (uint64_t)numOfItems * sizeof(WeightType);
+		auto priceBytes = (uint64_t)numOfItems * sizeof(PriceType);
+
+		bool isWritten = WriteSlot(this->file, capacity)
+			&& WriteColumn(this->file, weights, numOfItems)
+			&& WriteColumn(this->file, prices, numOfItems);
+		if (!isWritten)this->Fail();
+
+		this->index.push_back(IndexEntry{ this->offset, (uint64_t)numOfItems });
+		this->offset += 8 + PadTo8(weightBytes) + PadTo8(priceBytes);
+	}
+
+	template<typename ItemContainerT>
+	void Write(const Knapsack<WeightType, PriceType, ItemContainerT> &knapsack) {
+		this->weights.clear();
+		this->prices.clear();
+		for (const auto &currentItem : knapsack.GetItems()) {
+			this->weights.push_back(currentItem.weight);
+			this->prices.push_back(currentItem.price);
+		}
+		this->Write(knapsack.GetMaxWeight(), this->weights.data(), this->prices.data(), this->weights.size());
+	}
+
+	void Close() {
+		using namespace KnapsackFileDetail;
+		if (this->file == nullptr)return;
+
+		FileHeader header{ instanceMagic, formatVersion, (uint32_t)sizeof(WeightType), (uint32_t)sizeof(PriceType),
+			(uint64_t)this->index.size(), this->offset };
+		bool isWritten = (this->index.empty()
+			|| fwrite(this->index.data(), sizeof(IndexEntry), this->index.size(), this->file) == this->index.size())
+			&& fseek(this->file, 0, SEEK_SET) == 0
+			&& fwrite(&header, sizeof(header), 1, this->file) == 1;
+		if (!isWritten)this->Fail();
+		if (fclose(this->file) != 0) {
+			this->file = nullptr;
+			throw runtime_error{ "cannot write the instance file" };
+		}
+		this->file = nullptr;
+	}
+
+private:
+	void Fail() {
+		fclose(this->file);
+		this->file = nullptr;
+		throw runtime_error{ "cannot write the instance file" };
+	}
+
+	FILE *file{ nullptr };
+	uint64_t offset{ 0 };
+	vector<KnapsackFileDetail::IndexEntry> index;
+	// the columns of Write(knapsack)
+	vector<WeightType> weights;
+	vector<PriceType> prices;
+};
+
+/*
+	A memory-mapped file of knapsack instances. The instances are read in
+	place without copying, and each one is checked against the file size
+	when it is accessed.
+*/
+template<typename WeightT, typename PriceT>
+class KnapsackInstanceFile {
+public:
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using ViewType = KnapsackInstanceView<WeightType, PriceType>;
+
+	explicit KnapsackInstanceFile(const string &path) :file{ path } {
+		using namespace KnapsackFileDetail;
+		if (this->file.GetSize() < sizeof(FileHeader))throw runtime_error{ path + " is not an instance file" };
+		memcpy(&this->header, this->file.GetData(), sizeof(FileHeader));
+		if (this->header.magic != instanceMagic || this->header.version != formatVersion)
+			throw runtime_error{ path + " is not an instance file" };
+		if (this->header.weightSize != sizeof(WeightType) || this->header.priceSize != sizeof(PriceType))
+			throw runtime_error{ path + " has different weight or price types" };
+
+		auto fileSize = (uint64_t)this->file.GetSize();
+		if (this->header.indexOffset > fileSize || this->header.indexOffset % 8 != 0
+			|| this->header.numOfInstances > (fileSize - this->header.indexOffset) / sizeof(IndexEntry))
+			throw runtime_error{ path + " has a broken index" };
+		this->index = (const IndexEntry *)(this->file.GetData() + this->header.indexOffset);
+	}
+
+	size_t GetNumOfInstances() const { return (size_t)this->header.numOfInstances; }
+
+	size_t GetNumOfItems(size_t instance) const {
+		return (size_t)this->index[instance].numOfItems;
+	}
+
+	ViewType GetInstance(size_t instance) const {
+		using namespace KnapsackFileDetail;
+		if (instance >= this->GetNumOfInstances())throw runtime_error{ "the instance is out of range" };
+		const auto &entry = this->index[instance];
+		auto weightBytes = PadTo8(entry.numOfItems * sizeof(WeightType));
+		auto priceBytes = PadTo8(entry.numOfItems * sizeof(PriceType));
+		auto instanceBytes = 8 + weightBytes + priceBytes;
+		if (entry.offset % 8 != 0 || entry.numOfItems > this->header.indexOffset
+			|| instanceBytes > this->header.indexOffset || entry.offset > this->header.indexOffset - instanceBytes)
+			throw runtime_error{ "the instance lies outside the file" };
+
+		auto data = this->file.GetData() + entry.offset;
+		ViewType view;
+		memcpy(&view.capacity, data, sizeof(WeightType));
+		view.numOfItems = (size_t)entry.numOfItems;
+		view.weights = (const WeightType *)(data + 8);
+		view.prices = (const PriceType *)(data + 8 + weightBytes);
+		return view;
+	}
+
+private:
+	MappedFile file;
+	KnapsackFileDetail::FileHeader header{};
+	const KnapsackFileDetail::IndexEntry *index{ nullptr };
+};
+
+/*
+	A memory-mapped result file written by BatchKnapsackSolver. The size
+	of a record depends on the number of items of its instance, so the
+	instance file it was solved from is needed to find the records, whose
+	offsets are computed and checked against the file size when it is
+	opened.
+*/
+template<typename WeightT, typename PriceT>
+class KnapsackResultFile {
+public:
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using ViewType = KnapsackResultView<WeightType, PriceType>;
+	using InstanceFileType = KnapsackInstanceFile<WeightType, PriceType>;
+
+	KnapsackResultFile(const string &path, const InstanceFileType &instances) :file{ path } {
+		using namespace KnapsackFileDetail;
+		if (this->file.GetSize() < sizeof(FileHeader))throw runtime_error{ path + " is not a result file" };
+		FileHeader header;
+		memcpy(&header, this->file.GetData(), sizeof(FileHeader));
+		if (header.magic != resultMagic || header.version != formatVersion)
+			throw runtime_error{ path + " is not a result file" };
+		if (header.weightSize != sizeof(WeightType) || header.priceSize != sizeof(PriceType))
+			throw runtime_error{ path + " has different weight or price types" };
+		if (header.numOfInstances != instances.GetNumOfInstances())
+			throw runtime_error{ path + " does not belong to the instance file" };
+
+		auto fileSize = (uint64_t)this->file.GetSize();
+		uint64_t offset = sizeof(FileHeader);
+		this->records.reserve(instances.GetNumOfInstances());
+		for (size_t i = 0; i < instances.GetNumOfInstances(); ++i) {
+			// at least a bit per item, so the record size cannot wrap around
+			auto numOfItems = (uint64_t)instances.GetNumOfItems(i);
+			if (numOfItems / 8 > fileSize - offset || GetResultRecordSize(numOfItems) > fileSize - offset)
+				throw runtime_error{ path + " is truncated" };
+			this->records.push_back(Record{ offset, numOfItems });
+			offset += GetResultRecordSize(numOfItems);
+		}
+	}
+
+	size_t GetNumOfResults() const { return this->records.size(); }
+
+	ViewType GetResult(size_t instance) const {
+		using namespace KnapsackFileDetail;
+		if (instance >= this->GetNumOfResults())throw runtime_error{ "the result is out of range" };
+		const auto &record = this->records[instance];
+		auto data = this->file.GetData() + record.offset;
+		uint64_t algorithm;
+		ViewType view;
+		memcpy(&view.price, data + resultPriceSlot, sizeof(PriceType));
+		memcpy(&view.weight, data + resultWeightSlot, sizeof(WeightType));
+		memcpy(&algorithm, data + resultAlgorithmSlot, sizeof(algorithm));
+		view.algorithm = (KnapsackAlgorithm)algorithm;
+		view.numOfItems = (size_t)record.numOfItems;
+		view.choiceWords = (const uint64_t *)(data + resultSlotsSize);
+		return view;
+	}
+
+private:
+	struct Record {
+		uint64_t offset;
+		uint64_t numOfItems;
+	};
+
+	MappedFile file;
+	vector<Record> records;
+};
+
+/*
+	Solves every instance of an instance file over a pool of threads and
+	writes the results in the order of the instances.
+
+	The instances are solved a block at a time: the workers take chunks of
+	a block from an atomic counter, and the results of the block are then
+	written sequentially before the next one starts. Every worker owns an
+	arena, a Knapsack and a KnapsackSolver reused for all its instances,
+	which is filled straight from the mapped columns and solved in place
+	with the algorithm SolveInPlace() selects. Once the buffers of the
+	arenas have grown to the largest instance, solving allocates nothing.
+	The calling thread works as one of the workers.
+
+	The arenas keep their DP decision matrices, so dpMemoryBudget bytes
+	are shared out evenly as the DP cell limit of every arena's solver;
+	instances whose DP would not fit in a share are solved without it.
+*/
+template<typename WeightT, typename PriceT>
+class BatchKnapsackSolver {
+public:
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using KnapsackType = Knapsack<WeightType, PriceType>;
+	using KnapsackSolverType = typename KnapsackType::KnapsackSolverType;
+	using ItemType = typename KnapsackType::ItemType;
+	using InstanceFileType = KnapsackInstanceFile<WeightType, PriceType>;
+
+	// the number of instances solved before their results are written
+	static constexpr size_t blockSize = 4096;
+	// the number of instances a worker takes from the counter at a time
+	static constexpr size_t chunkSize = 16;
+	// the memory the DP decision matrices of all workers may take together
+	static constexpr uint64_t defaultDPMemoryBudget = uint64_t(1) << 30;
+
+	explicit BatchKnapsackSolver(size_t numOfThreads = thread::hardware_concurrency(),
+		uint64_t dpMemoryBudget = defaultDPMemoryBudget) {
+		if (numOfThreads == 0)numOfThreads = 1;
+		this->arenas.resize(numOfThreads);
+		// one bit per cell, saturated rather than wrapped around
+		auto shareBytes = dpMemoryBudget / numOfThreads;
+		auto shareCells = (shareBytes > numeric_limits<uint64_t>::max() / 8) ? numeric_limits<uint64_t>::max() : shareBytes * 8;
+		for (auto &arena : this->arenas)arena.solver.SetMaxDPCells(shareCells);
+		// the calling thread acts as worker 0
+		for (size_t i = 1; i < numOfThreads; ++i) {
+			this->threads.emplace_back(&BatchKnapsackSolver::WorkerLoop, this, i);
+		}
+	}
+
+	BatchKnapsackSolver(const BatchKnapsackSolver &) = delete;
+	BatchKnapsackSolver &operator=(const BatchKnapsackSolver &) = delete;
+
+	~BatchKnapsackSolver() {
+		{
+			lock_guard<mutex> lock{ this->jobMutex };
+			this->isStopping = true;
+		}
+		this->wakeCondition.notify_all();
+		for (auto &worker : this->threads)worker.join();
+	}
+
+	size_t GetNumOfThreads() const { return this->arenas.size(); }
+
+	// solves every instance of the input file and writes the result file
+	void SolveFile(const string &inputPath, const string &outputPath) {
+		using namespace KnapsackFileDetail;
+		InstanceFileType input{ inputPath };
+		FILE *output = fopen(outputPath.c_str(), "wb");
+		if (output == nullptr)throw runtime_error{ "cannot create " + outputPath };
+
+		auto numOfInstances = input.GetNumOfInstances();
+		FileHeader header{ resultMagic, formatVersion, (uint32_t)sizeof(WeightType), (uint32_t)sizeof(PriceType),
+			(uint64_t)numOfInstances, 0 };
+		bool isWritten = (fwrite(&header, sizeof(header), 1, output) == 1);
+
+		for (size_t first = 0; first < numOfInstances && isWritten; first += blockSize) {
+			auto last = min(numOfInstances, first + blockSize);
+			this->SolveBlock(input, first, last);
+			isWritten = this->WriteBlock(output);
+		}
+		if (fclose(output) != 0 || !isWritten)throw runtime_error{ "cannot write " + outputPath };
+	}
+
+private:
+	struct Result {
+		PriceType price;
+		WeightType weight;
+		KnapsackAlgorithm algorithm;
+	};
+
+	struct Arena {
+		Arena() :solver{ knapsack } {}
+
+		KnapsackType knapsack;
+		KnapsackSolverType solver;
+		// the positions of the instance's items, sorted by weight and price
+		vector<size_t> order;
+		vector<ItemType> chosenItems;
+	};
+
+	// solves instances [first, last) into the block buffers
+	void SolveBlock(const InstanceFileType &input, size_t first, size_t last) {
+		auto numOfInstances = last - first;
+		this->blockResults.resize(numOfInstances);
+		this->blockChoiceOffsets.resize(numOfInstances + 1);
+		this->blockChoiceOffsets[0] = 0;
+		for (size_t i = 0; i < numOfInstances; ++i) {
+			// GetInstance() checks the instance lies inside the file
+			auto numOfItems = input.GetInstance(first + i).numOfItems;
+			auto numOfWords = (size_t)KnapsackFileDetail::GetNumOfChoiceWords(numOfItems);
+			this->blockChoiceOffsets[i + 1] = this->blockChoiceOffsets[i] + numOfWords;
+		}
+		this->blockChoices.assign(this->blockChoiceOffsets[numOfInstances], 0);
+
+		{
+			lock_guard<mutex> lock{ this->jobMutex };
+			this->input = &input;
+			this->firstInstance = first;
+			this->numOfBlockInstances = numOfInstances;
+			this->nextInstance.store(0);
+			this->numOfBusyThreads = this->threads.size();
+			++this->generation;
+		}
+		this->wakeCondition.notify_all();
+
+		this->ProcessInstances(this->arenas[0]);
+
+		unique_lock<mutex> lock{ this->jobMutex };
+		this->doneCondition.wait(lock, [this]() { return this->numOfBusyThreads == 0; });
+		// an exception in a worker is rethrown to the caller
+		if (this->error != nullptr) {
+			auto error = this->error;
+			this->error = nullptr;
+			rethrow_exception(error);
+		}
+	}
+
+	bool WriteBlock(FILE *output) const {
+		using namespace KnapsackFileDetail;
+		for (size_t i = 0; i < this->blockResults.size(); ++i) {
+			const auto &result = this->blockResults[i];
+			auto numOfWords = this->blockChoiceOffsets[i + 1] - this->blockChoiceOffsets[i];
+			bool isWritten = WriteSlot(output, result.price) && WriteSlot(output, result.weight)
+				&& WriteSlot(output, (uint64_t)result.algorithm)
+				&& fwrite(this->blockChoices.data() + this->blockChoiceOffsets[i], sizeof(uint64_t), numOfWords, output) == numOfWords;
+			if (!isWritten)return false;
+		}
+		return true;
+	}
+
+	void WorkerLoop(size_t index) {
+		size_t seenGeneration = 0;
+		while (true) {
+			{
+				unique_lock<mutex> lock{ this->jobMutex };
+				this->wakeCondition.wait(lock, [&]() {
+					return this->isStopping || this->generation != seenGeneration;
+				});
+				if (this->isStopping)return;
+				seenGeneration = this->generation;
+			}
+
+			this->ProcessInstances(this->arenas[index]);
+
+			lock_guard<mutex> lock{ this->jobMutex };
+			if (--this->numOfBusyThreads == 0)this->doneCondition.notify_one();
+		}
+	}
+
+	void ProcessInstances(Arena &arena) {
+		try {
+			while (true) {
+				auto begin = this->nextInstance.fetch_add(chunkSize);
+				if (begin >= this->numOfBlockInstances)return;
+				auto end = min(begin + chunkSize, this->numOfBlockInstances);
+				for (auto i = begin; i < end; ++i) {
+					auto view = this->input->GetInstance(this->firstInstance + i);
+					this->SolveInstance(arena, view, this->blockResults[i],
+						this->blockChoices.data() + this->blockChoiceOffsets[i]);
+				}
+			}
+		}
+		catch (...) {
+			lock_guard<mutex> lock{ this->jobMutex };
+			if (this->error == nullptr)this->error = current_exception();
+			// the other workers stop taking instances
+			this->nextInstance.store(this->numOfBlockInstances);
+		}
+	}
+
+	/*
+		The solver reorders the items when it backtracks, so the chosen items
+		are matched back to their positions in the instance by weight and
+		price. Equal items are interchangeable, so any matching will do.
+	*/
+	static void SolveInstance(Arena &arena, const KnapsackInstanceView<WeightType, PriceType> &view,
+		Result &result, uint64_t *choiceWords) {
+		auto &items = arena.knapsack.GetItems();
+		items.clear();
+		for (size_t i = 0; i < view.numOfItems; ++i) {
+			ItemType currentItem;
+			currentItem.weight = view.weights[i];
+			currentItem.price = view.prices[i];
+			items.push_back(currentItem);
+		}
+		arena.knapsack.SetMaxWeight(view.capacity);
+
+		result.algorithm = arena.solver.SolveInPlace();
+		result.price = arena.solver.GetBestPrice();
+		result.weight = 0;
+		const auto &choice = arena.solver.GetBestChoice();
+
+		if (result.algorithm != KnapsackAlgorithm::BranchAndBound) {
+			for (size_t i = 0; i < view.numOfItems; ++i) {
+				if (!choice[i])continue;
+				choiceWords[i / 64] |= uint64_t(1) << (i % 64);
+				result.weight += view.weights[i];
+			}
+			return;
+		}
+
+		auto itemLess = [](const ItemType &left, const ItemType &right) {
+			return left.weight < right.weight || (left.weight == right.weight && left.price < right.price);
+		};
+		arena.chosenItems.clear();
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (choice[i])arena.chosenItems.push_back(items[i]);
+		}
+		sort(arena.chosenItems.begin(), arena.chosenItems.end(), itemLess);
+
+		arena.order.resize(view.numOfItems);
+		for (size_t i = 0; i < view.numOfItems; ++i)arena.order[i] = i;
+		sort(arena.order.begin(), arena.order.end(), [&view](size_t left, size_t right) {
+			return view.weights[left] < view.weights[right]
+				|| (view.weights[left] == view.weights[right] && view.prices[left] < view.prices[right]);
+		});
+
+		auto orderIter = arena.order.begin();
+		for (const auto &chosenItem : arena.chosenItems) {
+			while (view.weights[*orderIter] != chosenItem.weight || view.prices[*orderIter] != chosenItem.price)++orderIter;
+			auto position = *orderIter++;
+			choiceWords[position / 64] |= uint64_t(1) << (position % 64);
+			result.weight += chosenItem.weight;
+		}
+	}
+
+	// arenas[i] belongs to worker i, a deque never moves them
+	deque<Arena> arenas;
+	vector<thread> threads;
+
+	// the block being solved, published under jobMutex
+	const InstanceFileType *input{ nullptr };
+	size_t firstInstance{ 0 };
+	size_t numOfBlockInstances{ 0 };
+	atomic<size_t> nextInstance{ 0 };
+	vector<Result> blockResults;
+	vector<uint64_t> blockChoices;
+	vector<size_t> blockChoiceOffsets;
+	exception_ptr error;
+
+	mutex jobMutex;
+	condition_variable wakeCondition;
+	condition_variable doneCondition;
+	size_t generation{ 0 };
+	size_t numOfBusyThreads{ 0 };
+	bool isStopping{ false };
+};
+
+#endif
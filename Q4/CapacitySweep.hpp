@@ -0,0 +1,106 @@
+#ifndef DEF_CAPACITYSWEEP_HPP
+#define DEF_CAPACITYSWEEP_HPP
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Knapsack.hpp"
+
+using namespace std;
+
+/*
+	The optimal price for every capacity from 0 to maxCapacity at once.
+
+	It is the DP over the capacity of KnapsackSolver::DPSolve(), with the
+	table kept after the solve: best[c] is the best price with total weight
+	at most c, so any capacity is answered in O(1). Whether item i improved
+	best[c] is kept in one bit per item and capacity, and the items of a
+	capacity are only rebuilt from those bits when they are asked for.
+	Adding an item is one more DP row, O(maxCapacity), on top of the table.
+	It takes O(maxCapacity) words and n * maxCapacity bits.
+*/
+template<typename WeightT, typename PriceT, typename ItemContainerT = vector<Item<WeightT, PriceT>>>
+class KnapsackCapacitySweep {
+public:
+	using KnapsackType = Knapsack<WeightT, PriceT, ItemContainerT>;
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using ItemType = Item<WeightType, PriceType>;
+	using ItemContainerType = typename KnapsackType::ItemContainerType;
+
+	static_assert(is_integral<WeightType>::value, "KnapsackCapacitySweep requires integral weights");
+
+	explicit KnapsackCapacitySweep(WeightType _maxCapacity) {
+		if (IsNegative(_maxCapacity))throw runtime_error{ "the capacity should not be negative" };
+		// the table has maxCapacity + 1 columns, which should not wrap around
+		if ((uint64_t)_maxCapacity >= (uint64_t)numeric_limits<size_t>::max())throw runtime_error{ "the capacity is too large for the table" };
+		this->maxCapacity = _maxCapacity;
+		auto width = (size_t)_maxCapacity + 1;
+		this->best.assign(width, 0);
+		this->decisions.Reset(0, width);
+	}
+
+	// the items of the knapsack, for capacities up to its own
+	explicit KnapsackCapacitySweep(const KnapsackType &knapsack) :
+		KnapsackCapacitySweep(knapsack, knapsack.GetMaxWeight()) {}
+
+	KnapsackCapacitySweep(const KnapsackType &knapsack, WeightType _maxCapacity) :
+		KnapsackCapacitySweep(_maxCapacity) {
+		for (const auto &currentItem : knapsack.GetItems())this->AddItem(currentItem);
+	}
+
+	// updates the table for one more item in O(maxCapacity)
+	void AddItem(const ItemType &newItem) {
+		auto row = this->decisions.GetNumOfRows();
+		this->decisions.AppendRow();
+		this->items.push_back(newItem);
+		if (IsNegative(newItem.weight) || newItem.weight > this->maxCapacity)return;
+
+		auto weight = (size_t)newItem.weight;
+		for (size_t capacity = this->best.size() - 1; capacity + 1 > weight; --capacity) {
+			auto candidate = this->best[capacity - weight] + newItem.price;
+			if (candidate > this->best[capacity]) {
+				this->best[capacity] = candidate;
+				this->decisions.Set(row, capacity);
+			}
+		}
+	}
+
+	// the best price with total weight at most capacity, in O(1)
+	PriceType GetOptimalPrice(WeightType capacity) const {
+		this->CheckCapacity(capacity);
+		return this->best[(size_t)capacity];
+	}
+
+	// the items of GetOptimalPrice(capacity), rebuilt in O(n)
+	ItemContainerType GetOptimalChoice(WeightType capacity) const {
+		this->CheckCapacity(capacity);
+		ItemContainerType result;
+		auto column = (size_t)capacity;
+		for (size_t i = this->items.size(); i-- > 0; ) {
+			if (this->decisions.Get(i, column)) {
+				result.push_back(this->items.at(i));
+				column -= (size_t)this->items.at(i).weight;
+			}
+		}
+		return result;
+	}
+
+	WeightType GetMaxCapacity() const { return this->maxCapacity; }
+	const ItemContainerType &GetItems() const { return this->items; }
+
+private:
+	void CheckCapacity(WeightType capacity) const {
+		if (IsNegative(capacity) || capacity > this->maxCapacity)throw runtime_error{ "the capacity is out of the table" };
+	}
+
+	WeightType maxCapacity{ 0 };
+	ItemContainerType items;
+	vector<PriceType> best;
+	// whether item i improved best[c], one row per item
+	BitMatrix decisions;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef DEF_COREKNAPSACK_HPP
+#define DEF_COREKNAPSACK_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../Common/ParallelRandom.hpp"
+#include "Knapsack.hpp"
+
+using namespace std;
+
+/*
+	A core problem solver for instances with a very large number of items,
+	in the spirit of Pisinger's expknap.
+
+	In an optimal solution almost every item with a price / weight ratio
+	well above the break item's is taken, and almost every item well below
+	it is not, so only a small core around the break item needs an exact
+	search. The solver
+	- finds the break item by weighted partitioning around random pivots
+	  (Balas-Zemel), in expected O(n) time and without sorting;
+	- solves a window of the items closest to the break ratio with
+	  KnapsackSolver, with the items above it taken and the items below
+	  it left out, which gives a lower bound;
+	- fixes every item outside the window whose Dembo-Hammer bound cannot
+	  beat the lower bound when it is flipped, and solves the window plus
+	  the items that could not be fixed;
+	- widens the window and tries again while too many items stay free.
+	Weights and prices have to be integers, so that the bounds are exact.
+	Strongly correlated items (price = weight + constant) hardly reduce,
+	and then the core grows to the whole instance.
+*/
+template<typename WeightT, typename PriceT, typename ItemContainerT = vector<Item<WeightT, PriceT>>>
+class CoreKnapsackSolver {
+public:
+	using KnapsackType = Knapsack<WeightT, PriceT, ItemContainerT>;
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using ItemType = Item<WeightType, PriceType>;
+	using ItemContainerType = typename KnapsackType::ItemContainerType;
+	using ProductType = typename KnapsackProductType<WeightType, PriceType>::Type;
+
+	static_assert(is_integral<WeightType>::value && is_integral<PriceType>::value,
+		"CoreKnapsackSolver requires integral weights and prices");
+
+	// the number of items on each side of the break item in the first window
+	static constexpr size_t initialCoreRadius = 16;
+	// the window grows by this factor while too many items stay free
+	static constexpr size_t coreGrowthFactor = 4;
+	// ranges of at most this many items are sorted instead of partitioned
+	static constexpr size_t maxSortedRangeSize = 16;
+	// cores are solved by DP if it takes no more cells than this
+	static constexpr uint64_t maxCoreDPCells = uint64_t(1) << 24;
+
+	CoreKnapsackSolver(KnapsackType &_knapsack) :knapsack{ _knapsack } {}
+
+	// unlike KnapsackSolver, this method does not change the item container
+	ItemContainerType Solve() {
+		const auto &items = this->knapsack.GetItems();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+
+		// items heavier than the knapsack never fit, and empty items are
+		// left out as their ratio of 0 / 0 would break the ordering
+		this->order.clear();
+		for (size_t i = 0; i < items.size(); ++i) {
+			const auto &currentItem = items.at(i);
+			if (currentItem.weight > maxWeight || (currentItem.weight == 0 && currentItem.price == 0))continue;
+			this->order.push_back(i);
+		}
+		this->isChosen.assign(items.size(), false);
+		this->bestChoice.assign(items.size(), false);
+		this->coreSize = 0;
+		this->numOfFixedItems = 0;
+
+		auto breakIndex = this->PartitionAtBreakItem();
+		this->breakPosition = breakIndex;
+		auto numOfItems = this->order.size();
+		if (breakIndex >= numOfItems) {
+			// everything fits
+			for (auto index : this->order)this->bestChoice[index] = true;
+			this->coreSize = 0;
+			this->numOfFixedItems = numOfItems;
+			return this->GetBestItems();
+		}
+
+		for (auto radius = initialCoreRadius; ; radius *= coreGrowthFactor) {
+			auto first = breakIndex > radius ? breakIndex - radius : 0;
+			auto last = min(numOfItems, breakIndex + radius);
+			this->SelectWindow(breakIndex, first, last);
+
+			// the window alone, with the items above it taken, is the lower bound
+			this->core.assign(this->order.begin() + first, this->order.begin() + last);
+			this->fixedItems.assign(this->order.begin(), this->order.begin() + first);
+			auto lowerBound = this->SolveCore();
+			this->bestChoice = this->isChosen;
+
+			bool isWholeInstance = (first == 0 && last == numOfItems);
+			if (isWholeInstance) {
+				this->coreSize = this->core.size();
+				this->numOfFixedItems = 0;
+				break;
+			}
+
+			// the items outside the window which cannot be fixed join the core
+			this->fixedItems.clear();
+			for (size_t i = 0; i < first; ++i) {
+				auto index = this->order[i];
+				if (this->CanFixAsTaken(index, lowerBound))this->fixedItems.push_back(index);
+				else this->core.push_back(index);
+			}
+			for (auto i = last; i < numOfItems; ++i) {
+				auto index = this->order[i];
+				if (!this->CanFixAsLeftOut(index, lowerBound))this->core.push_back(index);
+			}
+
+			auto numOfFreeItems = this->core.size() - (last - first);
+			if (numOfFreeItems > last - first)continue;
+
+			this->coreSize = this->core.size();
+			this->numOfFixedItems = numOfItems - this->core.size();
+			// no solution outside the reduced problem beats the lower bound
+			if (numOfFreeItems > 0 && this->SolveCore() > lowerBound)this->bestChoice = this->isChosen;
+			break;
+		}
+
+		return this->GetBestItems();
+	}
+
+	// the number of items in the core problem solved by the last call to Solve()
+	size_t GetCoreSize() const { return this->coreSize; }
+	// the number of items fixed by the reduction in the last call to Solve()
+	size_t GetNumOfFixedItems() const { return this->numOfFixedItems; }
+
+private:
+	// whether item left has a higher price / weight ratio than item right
+	bool IsMoreEfficient(size_t left, size_t right) const {
+		const auto &items = this->knapsack.GetItems();
+		const auto &leftItem = items.at(left);
+		const auto &rightItem = items.at(right);
+		return (ProductType)leftItem.price * (ProductType)rightItem.weight
+			> (ProductType)rightItem.price * (ProductType)leftItem.weight;
+	}
+
+	/*
+		Rearranges order so that the items before the returned position have
+		a ratio at least that of the break item there, and fit together in
+		the knapsack, while the items after it have a ratio at most the
+		break item's. Every round partitions the unresolved range into the
+		items above, equal to and below a random pivot, then keeps the part
+		that contains the break item. Returns the number of items if they
+		all fit. The Dantzig solution (the items before the break item) is
+		stored in dantzigWeight and dantzigPrice.
+	*/
+	size_t PartitionAtBreakItem() {
+		const auto &items = this->knapsack.GetItems();
+		WeightType capacityLeft = this->knapsack.GetMaxWeight();
+		this->dantzigPrice = 0;
+
+		Xoshiro256StarStar randomEngine;
+		auto first = this->order.begin();
+		auto last = this->order.end();
+		while (last - first > (ptrdiff_t)maxSortedRangeSize) {
+			auto pivot = *(first + (ptrdiff_t)UniformBelow(randomEngine, (uint64_t)(last - first)));
+			auto aboveEnd = partition(first, last, [this, pivot](size_t index) { return this->IsMoreEfficient(index, pivot); });
+			auto equalEnd = partition(aboveEnd, last, [this, pivot](size_t index) { return !this->IsMoreEfficient(pivot, index); });
+
+			WeightType aboveWeight{ 0 };
+			PriceType abovePrice{ 0 };
+			bool isAboveFitting = true;
+			for (auto iter = first; iter != aboveEnd; ++iter) {
+				const auto &currentItem = items.at(*iter);
+				if (currentItem.weight > capacityLeft - aboveWeight) {
+					isAboveFitting = false;
+					break;
+				}
+				aboveWeight += currentItem.weight;
+				abovePrice += currentItem.price;
+			}
+			if (!isAboveFitting) {
+				last = aboveEnd;
+				continue;
+			}
+			capacityLeft -= aboveWeight;
+			this->dantzigPrice += abovePrice;
+			first = aboveEnd;
+			// the equal items are taken one by one, any of them may be the break item
+			while (first != equalEnd && items.at(*first).weight <= capacityLeft) {
+				capacityLeft -= items.at(*first).weight;
+				this->dantzigPrice += items.at(*first).price;
+				++first;
+			}
+			if (first != equalEnd) {
+				this->dantzigWeight = this->knapsack.GetMaxWeight() - capacityLeft;
+				return (size_t)(first - this->order.begin());
+			}
+		}
+
+		sort(first, last, [this](size_t left, size_t right) { return this->IsMoreEfficient(left, right); });
+		while (first != last && items.at(*first).weight <= capacityLeft) {
+			capacityLeft -= items.at(*first).weight;
+			this->dantzigPrice += items.at(*first).price;
+			++first;
+		}
+		this->dantzigWeight = this->knapsack.GetMaxWeight() - capacityLeft;
+		return (size_t)(first - this->order.begin());
+	}
+
+	/*
+		Moves the least efficient items before the break item to
+		[first, breakIndex) and the most efficient items after it to
+		(breakIndex, last), both in linear time, so [first, last) is the
+		window of the items closest to the break ratio.
+	*/
+	void SelectWindow(size_t breakIndex, size_t first, size_t last) {
+		auto isMoreEfficient = [this](size_t left, size_t right) { return this->IsMoreEfficient(left, right); };
+		auto begin = this->order.begin();
+		if (first > 0)nth_element(begin, begin + (ptrdiff_t)first, begin + (ptrdiff_t)breakIndex, isMoreEfficient);
+		if (last < this->order.size())
+			nth_element(begin + (ptrdiff_t)breakIndex + 1, begin + (ptrdiff_t)last - 1, this->order.end(), isMoreEfficient);
+	}
+
+	/*
+		The Dembo-Hammer test. With the break item b and the Dantzig solution
+		of price P' and residual capacity c', the LP bound is
+		U = P' + c' * p_b / w_b, and flipping item j from its LP value lowers
+		it by |p_j - w_j * p_b / w_b|. If that is still below lowerBound + 1,
+		no better solution flips item j. Everything is multiplied by w_b to
+		stay in integers, and the terms are arranged so that each is a
+		single product.
+	*/
+	bool CanFixAsTaken(size_t index, PriceType lowerBound) const {
+		const auto &currentItem = this->knapsack.GetItems().at(index);
+		return this->GetBoundSlack(lowerBound)
+			< (ProductType)currentItem.price * (ProductType)this->GetBreakItem().weight
+			- (ProductType)this->GetBreakItem().price * (ProductType)currentItem.weight;
+	}
+
+	bool CanFixAsLeftOut(size_t index, PriceType lowerBound) const {
+		const auto &currentItem = this->knapsack.GetItems().at(index);
+		return this->GetBoundSlack(lowerBound)
+			< (ProductType)this->GetBreakItem().price * (ProductType)currentItem.weight
+			- (ProductType)currentItem.price * (ProductType)this->GetBreakItem().weight;
+	}
+
+	// (U - lowerBound - 1) * w_b, P' <= lowerBound < U keeps it small
+	ProductType GetBoundSlack(PriceType lowerBound) const {
+		const auto &breakItem = this->GetBreakItem();
+		WeightType capacityLeft = this->knapsack.GetMaxWeight() - this->dantzigWeight;
+		return ((ProductType)this->dantzigPrice - (ProductType)lowerBound - 1) * (ProductType)breakItem.weight
+			+ (ProductType)capacityLeft * (ProductType)breakItem.price;
+	}
+
+	const ItemType &GetBreakItem() const {
+		return this->knapsack.GetItems().at(this->order[this->breakPosition]);
+	}
+
+	/*
+		Solves the items in core exactly, with the items in fixedItems taken,
+		and marks the result in isChosen. The core is handed to KnapsackSolver
+		as a knapsack of its own. It is solved by branch and bound, unless
+		the capacity left for it is small enough for a quick DP, which does
+		not suffer from strongly correlated items. It returns the chosen items rather than
+		their positions, but equal items are interchangeable, so they are
+		matched back to the core by sorting both by weight and price.
+	*/
+	PriceType SolveCore() {
+		const auto &items = this->knapsack.GetItems();
+		WeightType capacity = this->knapsack.GetMaxWeight();
+		PriceType price{ 0 };
+		fill(this->isChosen.begin(), this->isChosen.end(), false);
+		for (auto index : this->fixedItems) {
+			capacity -= items.at(index).weight;
+			price += items.at(index).price;
+			this->isChosen[index] = true;
+		}
+
+		using CoreKnapsackType = Knapsack<WeightType, PriceType>;
+		typename CoreKnapsackType::ItemContainerType coreItems;
+		coreItems.reserve(this->core.size());
+		for (auto index : this->core)coreItems.push_back(items.at(index));
+		CoreKnapsackType coreKnapsack{ capacity };
+		coreKnapsack.AssignItems(move(coreItems));
+		typename CoreKnapsackType::KnapsackSolverType solver{ coreKnapsack };
+		// the table has capacity + 1 columns, compared without adding 1 so it cannot wrap
+		bool isDPCheap = (uint64_t)capacity < maxCoreDPCells / max<uint64_t>(this->core.size(), 1);
+		auto chosen = isDPCheap ? solver.DPSolve() : solver.SortedSolve();
+
+		auto itemLess = [](const ItemType &left, const ItemType &right) {
+			return left.weight < right.weight || (left.weight == right.weight && left.price < right.price);
+		};
+		sort(chosen.begin(), chosen.end(), itemLess);
+		sort(this->core.begin(), this->core.end(), [&items, &itemLess](size_t left, size_t right) {
+			return itemLess(items.at(left), items.at(right));
+		});
+		auto coreIter = this->core.begin();
+		for (const auto &chosenItem : chosen) {
+			while (itemLess(items.at(*coreIter), chosenItem))++coreIter;
+			this->isChosen[*coreIter++] = true;
+			price += chosenItem.price;
+		}
+		return price;
+	}
+
+	ItemContainerType GetBestItems() const {
+		ItemContainerType result;
+		for (size_t i = 0; i < this->bestChoice.size(); ++i) {
+			if (this->bestChoice[i])result.push_back(this->knapsack.GetItems().at(i));
+		}
+		return result;
+	}
+
+	KnapsackType &knapsack;
+
+	// the indices of the items that fit, partitioned around the break item
+	vector<size_t> order;
+	size_t breakPosition{ 0 };
+	WeightType dantzigWeight{ 0 };
+	PriceType dantzigPrice{ 0 };
+
+	// the current core problem and the items fixed as taken
+	vector<size_t> core;
+	vector<size_t> fixedItems;
+	vector<bool> isChosen;
+	vector<bool> bestChoice;
+
+	size_t coreSize{ 0 };
+	size_t numOfFixedItems{ 0 };
+};
+
+#endif
@@ -5,6 +5,15 @@
 #include <vector>
 #include <limits>
 #include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <sstream>
 
 using namespace std;
 
@@ -19,9 +28,191 @@ struct Item {
 	FPType GetPriceWeightRatio() const { return (FPType)this->price / (FPType)this->weight; }
 };
 
-template<typename WeightT, typename PriceT, typename ItemContainerT>
+// whether a weight or a price is below zero, without comparing
+// unsigned values with 0
+template<typename Type>
+bool IsNegative(Type value, true_type) { return value < 0; }
+
+template<typename Type>
+bool IsNegative(Type, false_type) { return false; }
+
+template<typename Type>
+bool IsNegative(Type value) { return IsNegative(value, is_signed<Type>{}); }
+
+/*
+	A type which holds the product of a weight and a price exactly, so that
+	price / weight ratios are compared by cross-multiplication instead of
+	division. Integers of up to 32 bits use 64-bit products, and 64-bit
+	integers use 128-bit products where the compiler has them. Anything
+	else falls back to long double, which is only exact for small values.
+*/
+template<typename WeightT, typename PriceT, typename Enable = void>
+struct KnapsackProductType {
+	using Type = long double;
+};
+
+template<typename WeightT, typename PriceT>
+struct KnapsackProductType<WeightT, PriceT, typename enable_if<is_integral<WeightT>::value && is_integral<PriceT>::value
+	&& sizeof(WeightT) <= 4 && sizeof(PriceT) <= 4>::type> {
+	using Type = typename conditional<is_unsigned<WeightT>::value && is_unsigned<PriceT>::value, uint64_t, int64_t>::type;
+};
+
+#ifdef __SIZEOF_INT128__
+template<typename WeightT, typename PriceT>
+struct KnapsackProductType<WeightT, PriceT, typename enable_if<is_integral<WeightT>::value && is_integral<PriceT>::value
+	&& (sizeof(WeightT) > 4 || sizeof(PriceT) > 4) && sizeof(WeightT) <= 8 && sizeof(PriceT) <= 8>::type> {
+	using Type = typename conditional<is_unsigned<WeightT>::value && is_unsigned<PriceT>::value, unsigned __int128, __int128>::type;
+};
+#endif
+
+// why a subtree of a branch-and-bound search is not searched
+enum class KnapsackPruneReason {
+	// its upper bound cannot beat the incumbent
+	Bound,
+	// the item does not fit, so the "take" branch is infeasible
+	Capacity,
+	// the budget of AnytimeSolve() ran out while it was open
+	Budget
+};
+
+/*
+	The statistics policies of KnapsackSolver. The solver calls the hooks
+	below from its searches, and with NoSearchStatistics they are empty
+	inline functions which the compiler removes entirely.
+*/
+struct NoSearchStatistics {
+	void Reset() {}
+	void OnNodeVisited(size_t) {}
+	void OnBoundEvaluated() {}
+	void OnPruned(KnapsackPruneReason, size_t = 1) {}
+	void OnIncumbentImproved(double) {}
+};
+
+/*
+	Counts the work of the searches, from the last Reset(), which every
+	solve calls. The prices of the incumbents are recorded as doubles,
+	so that the statistics do not depend on the price type.
+*/
+struct SearchStatistics {
+	// an improvement of the incumbent, after numOfVisitedNodes nodes
+	struct Improvement {
+		double price;
+		size_t numOfVisitedNodes;
+		chrono::nanoseconds time;
+	};
+
+	size_t numOfVisitedNodes{ 0 };
+	size_t numOfBoundEvaluations{ 0 };
+	// indexed by KnapsackPruneReason
+	size_t numOfPrunedNodes[3]{};
+	size_t maxDepth{ 0 };
+	vector<Improvement> improvements;
+	chrono::steady_clock::time_point startTime;
+
+	void Reset() {
+		this->numOfVisitedNodes = 0;
+		this->numOfBoundEvaluations = 0;
+		fill(begin(this->numOfPrunedNodes), end(this->numOfPrunedNodes), 0);
+		this->maxDepth = 0;
+		this->improvements.clear();
+		this->startTime = chrono::steady_clock::now();
+	}
+
+	void OnNodeVisited(size_t depth) {
+		++this->numOfVisitedNodes;
+		if (depth > this->maxDepth)this->maxDepth = depth;
+	}
+
+	void OnBoundEvaluated() { ++this->numOfBoundEvaluations; }
+
+	void OnPruned(KnapsackPruneReason reason, size_t numOfNodes = 1) {
+		this->numOfPrunedNodes[(size_t)reason] += numOfNodes;
+	}
+
+	void OnIncumbentImproved(double price) {
+		auto time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - this->startTime);
+		this->improvements.push_back(Improvement{ price, this->numOfVisitedNodes, time });
+	}
+
+	size_t GetNumOfPrunedNodes(KnapsackPruneReason reason) const {
+		return this->numOfPrunedNodes[(size_t)reason];
+	}
+
+	// the statistics as a JSON object, the times in microseconds
+	string ToJSON() const {
+		ostringstream stream;
+		stream << "{\"visitedNodes\":" << this->numOfVisitedNodes
+			<< ",\"boundEvaluations\":" << this->numOfBoundEvaluations
+			<< ",\"prunedNodes\":{\"bound\":" << this->GetNumOfPrunedNodes(KnapsackPruneReason::Bound)
+			<< ",\"capacity\":" << this->GetNumOfPrunedNodes(KnapsackPruneReason::Capacity)
+			<< ",\"budget\":" << this->GetNumOfPrunedNodes(KnapsackPruneReason::Budget)
+			<< "},\"maxDepth\":" << this->maxDepth
+			<< ",\"improvements\":[";
+		stream.precision(17);
+		for (size_t i = 0; i < this->improvements.size(); ++i) {
+			const auto &improvement = this->improvements[i];
+			if (i > 0)stream << ",";
+			stream << "{\"price\":" << improvement.price
+				<< ",\"visitedNodes\":" << improvement.numOfVisitedNodes
+				<< ",\"microseconds\":" << chrono::duration_cast<chrono::microseconds>(improvement.time).count() << "}";
+		}
+		stream << "]}";
+		return stream.str();
+	}
+};
+
+template<typename WeightT, typename PriceT, typename ItemContainerT, typename StatisticsT = NoSearchStatistics>
 class KnapsackSolver;
 
+// the algorithms KnapsackSolver::Solve() chooses from
+enum class KnapsackAlgorithm {
+	// backtracking over the items sorted by price / weight ratio
+	BranchAndBound,
+	// dynamic programming over the capacity, O(n * W)
+	WeightDP,
+	// dynamic programming over the total price, O(n * P)
+	ProfitDP,
+	// merging the subset sums of two halves of the items, O(2^(n/2))
+	MeetInTheMiddle
+};
+
+// a dense matrix of bits, packed 64 to a word
+class BitMatrix {
+public:
+	BitMatrix() {}
+	BitMatrix(size_t _numOfRows, size_t _numOfColumns) {
+		this->Reset(_numOfRows, _numOfColumns);
+	}
+
+	// resizes the matrix and clears all bits, reusing the memory if possible
+	void Reset(size_t _numOfRows, size_t _numOfColumns) {
+		this->numOfRows = _numOfRows;
+		this->wordsPerRow = (_numOfColumns + 63) / 64;
+		this->words.assign(this->numOfRows * this->wordsPerRow, 0);
+	}
+
+	// adds a row of clear bits at the bottom
+	void AppendRow() {
+		this->words.resize(this->words.size() + this->wordsPerRow, 0);
+		++this->numOfRows;
+	}
+
+	void Set(size_t row, size_t column) {
+		this->words[row * this->wordsPerRow + column / 64] |= uint64_t(1) << (column % 64);
+	}
+
+	bool Get(size_t row, size_t column) const {
+		return (this->words[row * this->wordsPerRow + column / 64] >> (column % 64)) & 1;
+	}
+
+	size_t GetNumOfRows() const { return this->numOfRows; }
+
+private:
+	size_t numOfRows{ 0 };
+	size_t wordsPerRow{ 0 };
+	vector<uint64_t> words;
+};
+
 template<typename WeightT, typename PriceT, typename ItemContainerT = vector<Item<WeightT, PriceT>>>
 class Knapsack {
 public:
@@ -34,9 +225,18 @@ public:
 
 private:
 
+	// left.price / left.weight > right.price / right.weight, without division
 	struct ItemSortingPredicate {
 		bool operator()(const ItemType &left, const ItemType &right) const {
-			return left.GetPriceWeightRatio() > right.GetPriceWeightRatio();
+			using ProductType = typename KnapsackProductType<WeightType, PriceType>::Type;
+			return (ProductType)left.price * (ProductType)GetSortingWeight(right)
+				> (ProductType)right.price * (ProductType)GetSortingWeight(left);
+		}
+
+		// an empty item is ordered as a ratio of 0 rather than 0 / 0,
+		// which would be equivalent to every item and break the ordering
+		static WeightType GetSortingWeight(const ItemType &item) {
+			return (item.weight == 0 && item.price == 0) ? WeightType(1) : item.weight;
 		}
 	};
 
@@ -70,10 +270,10 @@ public:
 		return result;
 	}
 
-	// this method will call SortItems()
+	// this method might call SortItems(), see KnapsackSolver::Solve()
 	ItemContainerType GetOptimalChoice() {
 		KnapsackSolverType solver{ *this };
-		return solver.BacktrackSorted();
+		return solver.Solve();
 	}
 
 private:
@@ -87,8 +287,10 @@ private:
 	Unlike general backtracking algorithms, which generate feasible solutions,
 	the knapsack problem requires an optimal solution. Thus a special algorithm
 	which traverses through the entire solution space is needed.
+	StatisticsT records the work of the branch-and-bound searches, see
+	SearchStatistics, and costs nothing by default.
 */
-template<typename WeightT, typename PriceT, typename ItemContainerT>
+template<typename WeightT, typename PriceT, typename ItemContainerT, typename StatisticsT>
 class KnapsackSolver {
 public:
 	using KnapsackType = Knapsack<WeightT, PriceT, ItemContainerT>;
@@ -96,36 +298,766 @@ public:
 	using PriceType = PriceT;
 	using ItemType = Item<WeightType, PriceType>;
 	using ItemContainerType = typename KnapsackType::ItemContainerType;
+	using FPType = typename ItemType::FPType;
+	// the prefix sums of the weights and the prices, which do not wrap around
+	using SumType = typename KnapsackProductType<WeightType, PriceType>::Type;
+	using StatisticsType = StatisticsT;
+
+	// instances with no more items than this are always solved by backtracking
+	static constexpr size_t maxBacktrackOnlySize = 24;
+	// the default of the largest number of cells (items times table width)
+	// a DP may use, the decision matrix takes one bit per cell, so 1 GiB
+	static constexpr uint64_t defaultMaxDPCells = uint64_t(1) << 33;
+	// the largest width of the rolling DP array
+	static constexpr uint64_t maxDPWidth = uint64_t(1) << 26;
+	// instances too large for a DP are solved by meet in the middle up to
+	// this number of items, each half then has at most 2^24 subset sums
+	static constexpr size_t maxMeetInTheMiddleSize = 48;
 
 	KnapsackSolver(KnapsackType &_knapsack) :knapsack{ _knapsack } {}
 
+	/*
+		The largest number of cells a DP chosen by Solve() may use. The
+		decision matrix is kept for the next solve rather than freed, so a
+		solver reused for many knapsacks holds up to maxDPCells bits. It
+		does not limit DPSolve() and ProfitDPSolve(), which are asked for.
+	*/
+	void SetMaxDPCells(uint64_t _maxDPCells) { this->maxDPCells = _maxDPCells; }
+	uint64_t GetMaxDPCells() const { return this->maxDPCells; }
+
+	/*
+		Chooses an algorithm from the number of items, the capacity and the
+		total price. Small instances are solved by backtracking. Otherwise
+		the DP with fewer cells (over the capacity for integral weights,
+		over the total price for integral prices) is used if it fits in
+		memory, then meet in the middle if there are few enough items, and
+		backtracking is the last resort.
+	*/
+	KnapsackAlgorithm SelectAlgorithm() const {
+		const auto &items = this->knapsack.GetItems();
+		if (items.size() <= maxBacktrackOnlySize)return KnapsackAlgorithm::BranchAndBound;
+
+		auto numOfItems = (uint64_t)items.size();
+		auto weightCells = numeric_limits<uint64_t>::max();
+		auto profitCells = numeric_limits<uint64_t>::max();
+
+		auto width = this->GetWeightDPWidth(is_integral<WeightType>{});
+		if (width <= maxDPWidth)weightCells = width * numOfItems;
+		width = this->GetProfitDPWidth(is_integral<PriceType>{});
+		if (width <= maxDPWidth)profitCells = width * numOfItems;
+
+		auto cells = min(weightCells, profitCells);
+		if (cells > this->maxDPCells) {
+			if (items.size() <= maxMeetInTheMiddleSize)return KnapsackAlgorithm::MeetInTheMiddle;
+			return KnapsackAlgorithm::BranchAndBound;
+		}
+		return (weightCells <= profitCells) ? KnapsackAlgorithm::WeightDP : KnapsackAlgorithm::ProfitDP;
+	}
+
+	// solves with the algorithm chosen by SelectAlgorithm(),
+	// which sorts the knapsack item container for backtracking
+	ItemContainerType Solve() {
+		this->SolveInPlace();
+		return this->GetBestItems();
+	}
+
+	/*
+		Solves like Solve(), but leaves the solution in GetBestChoice() and
+		GetBestPrice() instead of copying the items out, so a solver which is
+		reused for many knapsacks stops allocating once its buffers have
+		grown. Returns the algorithm used.
+	*/
+	KnapsackAlgorithm SolveInPlace() {
+		auto algorithm = this->SelectAlgorithm();
+		switch (algorithm) {
+		case KnapsackAlgorithm::WeightDP:
+			this->RunWeightDP(is_integral<WeightType>{});
+			break;
+		case KnapsackAlgorithm::ProfitDP:
+			this->RunProfitDP(is_integral<PriceType>{});
+			break;
+		case KnapsackAlgorithm::MeetInTheMiddle:
+			this->RunMeetInTheMiddle();
+			break;
+		default:
+			this->RunSorted();
+			break;
+		}
+		return algorithm;
+	}
+
+	// whether each item of the knapsack, in its current order, is in the last solution
+	const vector<bool> &GetBestChoice() const { return this->bestChoice; }
+	PriceType GetBestPrice() const { return this->bestPrice; }
+
 	// this method will sort the knapsack item container
 	ItemContainerType SortedSolve() {
+		this->RunSorted();
+		return this->GetBestItems();
+	}
+
+	ItemContainerType DirectSolve() {
 		this->Init();
-		this->choice.resize(this->knapsack.GetItems().size(), false);
-		this->bestChoice.resize(this->knapsack.GetItems().size(), false);
 
+		this->BacktrackDirect(0);
+
+		return this->GetBestItems();
+	}
+
+	/*
+		0-1 knapsack by dynamic programming over the capacity, which needs
+		integral weights. best[c] is the best price with total weight at most c
+		among the items seen so far, and is updated in place from the largest
+		capacity down. Whether item i improves best[c] is kept in one bit, so
+		the choice is rebuilt by walking the bits backwards from the full
+		capacity. It takes O(n * W) time, O(W) words and n * W bits.
+	*/
+	ItemContainerType DPSolve() {
+		static_assert(is_integral<WeightType>::value, "DPSolve() requires integral weights");
+		this->RunWeightDP(true_type{});
+		return this->GetBestItems();
+	}
+
+	/*
+		0-1 knapsack by dynamic programming over the total price, which needs
+		integral prices. lightest[q] is the least weight to reach a total price
+		of exactly q. It takes O(n * P) time where P is the sum of the prices,
+		so it is the better choice for large capacities with small prices.
+	*/
+	ItemContainerType ProfitDPSolve() {
+		static_assert(is_integral<PriceType>::value, "ProfitDPSolve() requires integral prices");
+		this->RunProfitDP(true_type{});
+		return this->GetBestItems();
+	}
+
+	/*
+		Horowitz-Sahni meet in the middle. The subset sums of each half of
+		the items are generated in order of weight: adding an item to a sorted
+		list gives a second sorted list, and merging both keeps the order, so
+		nothing is ever sorted. Sums over the capacity are dropped, and so is
+		every sum that is not lighter than another one with at least its
+		price. Both lists are then strictly increasing in weight and price,
+		so one sweep, with the left half going up and the right half coming
+		down, pairs every left sum with the best right sum that still fits.
+		It takes O(2^(n/2)) time and memory whatever the weights are, so it
+		suits few items with a huge capacity.
+	*/
+	ItemContainerType MeetInTheMiddleSolve() {
+		this->RunMeetInTheMiddle();
+		return this->GetBestItems();
+	}
+
+	/*
+		Best-first branch and bound. Open nodes are kept in a priority queue
+		ordered by their upper bound, so the most promising subtree is always
+		expanded next, and the search ends as soon as no open node can beat
+		the incumbent. The bound is the Martello-Toth bound U2, which is never
+		weaker than the Dantzig bound used by BacktrackSorted(), and the
+		incumbent starts from the greedy solution. Nodes only hold the last
+		decision and the index of their parent in a node pool, and the best
+		choice is rebuilt from the parent links at the end.
+		This method will sort the knapsack item container.
+	*/
+	ItemContainerType BestFirstSolve() {
+		this->Init();
 		this->knapsack.SortItems();
+		this->BuildColumns();
 
-		this->BacktrackSorted(0);
+		this->TakeGreedyItems();
+		this->BestFirstSearch(SearchBudget{});
 
-		ItemContainerType result;
-		for (auto i = 0U; i < this->bestChoice.size(); ++i) {
-			if (this->bestChoice[i])
-				// avoid using operator[] (not incrementing the counter)
-				result.push_back(this->knapsack.GetItems().at(i));
+		return this->GetBestItems();
+	}
+
+	// the result of AnytimeSolve()
+	struct AnytimeResult {
+		ItemContainerType items;
+		PriceType price;
+		// no solution has a higher price than this
+		PriceType upperBound;
+		// (upperBound - price) / upperBound, 0 if the solution is optimal
+		double gap;
+		bool isOptimal;
+	};
+
+	/*
+		Solves within a budget and returns the best solution found so far,
+		together with an upper bound proven by the search. The incumbent
+		starts from the greedy solution improved by local search, which
+		takes at most a quarter of the time limit, then the search of
+		BestFirstSolve() runs until it is done or the time limit, the node
+		limit or the cancel flag stops it. As the open nodes are
+		ordered by their bound, the upper bound is that of the first open
+		node. The cancel flag may be set from another thread, and the clock
+		and the flag are checked every budgetCheckInterval nodes.
+		This method will sort the knapsack item container.
+	*/
+	AnytimeResult AnytimeSolve(chrono::nanoseconds timeLimit,
+		size_t maxNumOfNodes = numeric_limits<size_t>::max(), const atomic<bool> *isCancelled = nullptr) {
+		SearchBudget budget;
+		budget.maxNumOfNodes = maxNumOfNodes;
+		budget.isCancelled = isCancelled;
+		// the local search may take a quarter of the time, it is O(n^2) per round
+		auto localSearchBudget = budget;
+		auto now = chrono::steady_clock::now();
+		if (timeLimit < chrono::steady_clock::time_point::max() - now) {
+			budget.deadline = now + timeLimit;
+			localSearchBudget.deadline = now + timeLimit / 4;
 		}
 
+		this->Init();
+		this->knapsack.SortItems();
+		this->BuildColumns();
+
+		this->TakeGreedyItems();
+		this->ImproveByLocalSearch(localSearchBudget);
+		auto upperBound = this->BestFirstSearch(budget);
+
+		AnytimeResult result;
+		result.items = this->GetBestItems();
+		result.price = this->bestPrice;
+		// a bound rounded below the incumbent proves it all the same
+		result.upperBound = max(upperBound, this->bestPrice);
+		result.isOptimal = true;
+		result.gap = 0.0;
+		// only subtracted once it is above the price, as unsigned prices wrap around
+		if (result.upperBound > result.price) {
+			result.isOptimal = false;
+			result.gap = (double)(result.upperBound - result.price) / (double)result.upperBound;
+		}
 		return result;
 	}
 
-	ItemContainerType DirectSolve() {
+	// the number of search nodes expanded by the last solve,
+	// only counted by the branch-and-bound solvers
+	size_t GetNumOfExpandedNodes() const { return this->numOfExpandedNodes; }
+
+	// the statistics of the last solve, empty unless StatisticsT records them
+	const StatisticsType &GetStatistics() const { return this->statistics; }
+
+	// sorts the items and builds the columns without solving, so that a
+	// search run outside this solver can use GetPriceUpperBound()
+	void PrepareColumns() {
+		this->knapsack.SortItems();
+		this->BuildColumns();
+	}
+
+	/*
+		The Dantzig bound of the subproblem where items [0, depth) of the
+		sorted items are decided, with weight (at most the capacity) and
+		price taken so far. It only reads the columns and is not counted in
+		the statistics, so many threads may call it at once. Make sure that
+		PrepareColumns() or a solve over the sorted items has been called.
+	*/
+	PriceType GetPriceUpperBound(size_t depth, WeightType weight, PriceType price) const {
+		auto numOfItems = this->weights.size();
+		if (depth >= numOfItems)return price;
+
+		WeightType capacityLeft = this->knapsack.GetMaxWeight() - weight;
+		auto critical = this->FindCriticalItem(depth, capacityLeft);
+		PriceType maxPrice = price + (PriceType)(this->prefixPrices[critical] - this->prefixPrices[depth]);
+
+		// if not all items can be put in, just fill the knapsack
+		// according to the maximum price / weight ratio to get an
+		// upperbound of price, rounded down as no solution can reach
+		// a fraction of a price
+		if (critical < numOfItems) {
+			WeightType weightLeft = capacityLeft - (WeightType)(this->prefixWeights[critical] - this->prefixWeights[depth]);
+			maxPrice += this->GetFractionalPrice(weightLeft, critical, false);
+		}
+
+		return maxPrice;
+	}
+
+private:
+
+	// the bodies of the solvers, which leave the solution in bestChoice
+	void RunSorted() {
 		this->Init();
-		this->choice.resize(this->knapsack.GetItems().size(), false);
-		this->bestChoice.resize(this->knapsack.GetItems().size(), false);
 
-		this->BacktrackDirect(0);
+		this->knapsack.SortItems();
+		this->BuildColumns();
+
+		this->BacktrackSorted();
+	}
+
+	void RunWeightDP(true_type) {
+		this->Init();
+
+		const auto &items = this->knapsack.GetItems();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+		auto width = (size_t)this->GetWeightDPWidth(true_type{});
+
+		auto &best = this->dpPrices;
+		best.assign(width, 0);
+		this->decisions.Reset(items.size(), width);
+		for (size_t i = 0; i < items.size(); ++i) {
+			const auto &currentItem = items[i];
+			if (currentItem.weight > maxWeight || IsNegative(currentItem.weight))continue;
+			auto weight = (size_t)currentItem.weight;
+			for (size_t capacity = width - 1; capacity + 1 > weight; --capacity) {
+				auto candidate = best[capacity - weight] + currentItem.price;
+				if (candidate > best[capacity]) {
+					best[capacity] = candidate;
+					this->decisions.Set(i, capacity);
+				}
+			}
+		}
+
+		auto capacity = width - 1;
+		for (size_t i = items.size(); i-- > 0; ) {
+			if (this->decisions.Get(i, capacity)) {
+				this->bestChoice[i] = true;
+				capacity -= (size_t)items.at(i).weight;
+			}
+		}
+		this->bestPrice = best[width - 1];
+	}
+
+	// SolveInPlace() never selects a DP the types do not allow
+	void RunWeightDP(false_type) {
+		throw runtime_error{ "the DP over the capacity requires integral weights" };
+	}
+
+	void RunProfitDP(true_type) {
+		this->Init();
 
+		const auto &items = this->knapsack.GetItems();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+		auto width = (size_t)this->GetProfitDPWidth(true_type{});
+		const auto unreachable = numeric_limits<WeightType>::max();
+
+		auto &lightest = this->dpWeights;
+		lightest.assign(width, unreachable);
+		lightest[0] = 0;
+		this->decisions.Reset(items.size(), width);
+		size_t reachable = 0;
+		for (size_t i = 0; i < items.size(); ++i) {
+			const auto &currentItem = items[i];
+			if (currentItem.weight > maxWeight || currentItem.price <= 0)continue;
+			auto price = (size_t)currentItem.price;
+			reachable += price;
+			for (size_t total = reachable; total + 1 > price; --total) {
+				// also skips unreachable totals, and keeps the sum from overflowing
+				if (lightest[total - price] > maxWeight - currentItem.weight)continue;
+				auto candidate = lightest[total - price] + currentItem.weight;
+				if (candidate < lightest[total]) {
+					lightest[total] = candidate;
+					this->decisions.Set(i, total);
+				}
+			}
+		}
+
+		size_t total = reachable;
+		while (lightest[total] == unreachable)--total;
+		this->bestPrice = (PriceType)total;
+		for (size_t i = items.size(); i-- > 0; ) {
+			if (this->decisions.Get(i, total)) {
+				this->bestChoice[i] = true;
+				total -= (size_t)items.at(i).price;
+			}
+		}
+	}
+
+	void RunProfitDP(false_type) {
+		throw runtime_error{ "the DP over the total price requires integral prices" };
+	}
+
+	void RunMeetInTheMiddle() {
+		this->Init();
+
+		const auto &items = this->knapsack.GetItems();
+		auto numOfItems = items.size();
+		auto half = numOfItems / 2;
+		// the choices within each half are kept in 64-bit masks
+		if (numOfItems - half > 64)throw runtime_error{ "too many items for meet in the middle" };
+
+		this->GenerateSubsetSums(0, half, this->leftSums);
+		this->GenerateSubsetSums(half, numOfItems, this->rightSums);
+
+		auto maxWeight = this->knapsack.GetMaxWeight();
+		auto right = this->rightSums.size();
+		const SubsetSum *bestLeft = nullptr;
+		const SubsetSum *bestRight = nullptr;
+		for (const auto &left : this->leftSums) {
+			// the empty subset is always in the right list, so it never runs out
+			while (this->rightSums[right - 1].weight > maxWeight - left.weight)--right;
+			const auto &matched = this->rightSums[right - 1];
+			if (bestLeft == nullptr || left.price + matched.price > this->bestPrice) {
+				this->bestPrice = left.price + matched.price;
+				bestLeft = &left;
+				bestRight = &matched;
+			}
+		}
+
+		for (size_t i = 0; i < half; ++i) {
+			this->bestChoice[i] = (bestLeft->choice >> i) & 1;
+		}
+		for (size_t i = half; i < numOfItems; ++i) {
+			this->bestChoice[i] = (bestRight->choice >> (i - half)) & 1;
+		}
+	}
+
+	static constexpr uint32_t noNode = numeric_limits<uint32_t>::max();
+	// the number of nodes between two checks of the clock and the cancel flag
+	static constexpr size_t budgetCheckInterval = 64;
+
+	// the limits of an anytime search, none by default
+	struct SearchBudget {
+		chrono::steady_clock::time_point deadline{ chrono::steady_clock::time_point::max() };
+		size_t maxNumOfNodes{ numeric_limits<size_t>::max() };
+		const atomic<bool> *isCancelled{ nullptr };
+
+		bool IsInterrupted() const {
+			if (this->isCancelled != nullptr && this->isCancelled->load(memory_order_relaxed))return true;
+			return this->deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= this->deadline;
+		}
+
+		bool IsExhausted(size_t numOfNodes) const {
+			if (numOfNodes >= this->maxNumOfNodes)return true;
+			return numOfNodes % budgetCheckInterval == 0 && this->IsInterrupted();
+		}
+	};
+
+	// the greedy solution over the sorted items, as the incumbent
+	void TakeGreedyItems() {
+		auto maxWeight = this->knapsack.GetMaxWeight();
+		WeightType greedyWeight{ 0 };
+		for (size_t i = 0; i < this->weights.size(); ++i) {
+			if (this->weights[i] <= maxWeight - greedyWeight) {
+				greedyWeight += this->weights[i];
+				this->bestPrice += this->prices[i];
+				this->bestChoice[i] = true;
+			}
+		}
+		if (this->bestPrice > 0)this->statistics.OnIncumbentImproved((double)this->bestPrice);
+	}
+
+	/*
+		Improves the incumbent by adding items that still fit, and by
+		swapping a taken item for a dearer one that is not taken, until
+		no move helps. Every move raises the price, so it ends.
+	*/
+	void ImproveByLocalSearch(const SearchBudget &budget) {
+		auto numOfItems = this->weights.size();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+		WeightType weight{ 0 };
+		for (size_t i = 0; i < numOfItems; ++i) {
+			if (this->bestChoice[i])weight += this->weights[i];
+		}
+
+		bool isImproved = true;
+		while (isImproved) {
+			isImproved = false;
+			for (size_t j = 0; j < numOfItems; ++j) {
+				if (!this->bestChoice[j] && this->weights[j] <= maxWeight - weight) {
+					this->bestChoice[j] = true;
+					weight += this->weights[j];
+					this->bestPrice += this->prices[j];
+				}
+			}
+			for (size_t i = 0; i < numOfItems; ++i) {
+				if (!this->bestChoice[i])continue;
+				if (budget.IsInterrupted())return;
+				WeightType roomLeft = maxWeight - weight + this->weights[i];
+				for (size_t j = 0; j < numOfItems; ++j) {
+					if (this->bestChoice[j] || this->prices[j] <= this->prices[i] || this->weights[j] > roomLeft)continue;
+					this->bestChoice[i] = false;
+					this->bestChoice[j] = true;
+					weight = weight - this->weights[i] + this->weights[j];
+					this->bestPrice = this->bestPrice - this->prices[i] + this->prices[j];
+					this->statistics.OnIncumbentImproved((double)this->bestPrice);
+					isImproved = true;
+					break;
+				}
+			}
+		}
+	}
+
+	/*
+		The search of BestFirstSolve(), starting from the incumbent in
+		bestChoice and bestPrice. Returns the best bound of the open nodes
+		if the budget stops it, or bestPrice once the search is done.
+	*/
+	PriceType BestFirstSearch(const SearchBudget &budget) {
+		auto numOfItems = this->weights.size();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+
+		this->nodePool.clear();
+		this->openNodes.clear();
+		auto boundLess = [this](uint32_t left, uint32_t right) {
+			return this->nodePool[left].bound < this->nodePool[right].bound;
+		};
+
+		SearchNode root;
+		root.bound = this->GetMartelloTothBound(0, 0, 0);
+		this->nodePool.push_back(root);
+		this->openNodes.push_back(0);
+		uint32_t bestNode = noNode;
+		PriceType upperBound = this->bestPrice;
+
+		while (!this->openNodes.empty()) {
+			// the best open bound cannot beat the incumbent, so nothing can
+			auto topBound = this->nodePool[this->openNodes.front()].bound;
+			if (topBound <= this->bestPrice) {
+				this->statistics.OnPruned(KnapsackPruneReason::Bound, this->openNodes.size());
+				break;
+			}
+			if (budget.IsExhausted(this->numOfExpandedNodes)) {
+				this->statistics.OnPruned(KnapsackPruneReason::Budget, this->openNodes.size());
+				upperBound = topBound;
+				break;
+			}
+
+			pop_heap(this->openNodes.begin(), this->openNodes.end(), boundLess);
+			auto index = this->openNodes.back();
+			this->openNodes.pop_back();
+			// copy, since pushing children may move the pool
+			auto node = this->nodePool[index];
+
+			++this->numOfExpandedNodes;
+			this->statistics.OnNodeVisited(node.level);
+			if (node.level >= numOfItems)continue;
+
+			auto itemWeight = this->weights[node.level];
+			SearchNode child;
+			child.level = node.level + 1;
+			child.parent = index;
+
+			// node.weight never exceeds maxWeight, so the subtraction cannot wrap
+			if (itemWeight <= maxWeight - node.weight) {
+				child.isTaken = true;
+				child.weight = node.weight + itemWeight;
+				child.price = node.price + this->prices[node.level];
+				child.bound = this->GetMartelloTothBound(child.level, child.weight, child.price);
+				bool isImproving = (child.price > this->bestPrice);
+				if (isImproving) {
+					this->bestPrice = child.price;
+					this->statistics.OnIncumbentImproved((double)this->bestPrice);
+				}
+				bool isOpen = (child.bound > this->bestPrice);
+				if (!isOpen)this->statistics.OnPruned(KnapsackPruneReason::Bound);
+				// the incumbent node is kept in the pool even if it is not opened
+				if (isImproving || isOpen) {
+					auto childIndex = this->PushNode(child, isOpen, boundLess);
+					if (isImproving)bestNode = childIndex;
+				}
+			}
+			else {
+				this->statistics.OnPruned(KnapsackPruneReason::Capacity);
+			}
+
+			child.isTaken = false;
+			child.weight = node.weight;
+			child.price = node.price;
+			child.bound = this->GetMartelloTothBound(child.level, child.weight, child.price);
+			if (child.bound > this->bestPrice)this->PushNode(child, true, boundLess);
+			else this->statistics.OnPruned(KnapsackPruneReason::Bound);
+		}
+
+		// the items after the incumbent node are not taken
+		if (bestNode != noNode) {
+			fill(this->bestChoice.begin(), this->bestChoice.end(), false);
+			for (auto index = bestNode; index != 0; index = this->nodePool[index].parent) {
+				const auto &node = this->nodePool[index];
+				this->bestChoice[node.level - 1] = node.isTaken;
+			}
+		}
+
+		return max(upperBound, this->bestPrice);
+	}
+
+	// a node of BestFirstSolve(), decisions on items [0, level) are made
+	struct SearchNode {
+		PriceType price{ 0 };
+		PriceType bound{ 0 };
+		WeightType weight{ 0 };
+		uint32_t level{ 0 };
+		uint32_t parent{ 0 };
+		bool isTaken{ false };
+	};
+
+	// a subset of half of the items, bit i of choice is item first + i
+	struct SubsetSum {
+		WeightType weight;
+		PriceType price;
+		uint64_t choice;
+	};
+
+	/*
+		The undominated subset sums of items [first, last) in increasing
+		order of weight, built by merging in one item at a time.
+	*/
+	void GenerateSubsetSums(size_t first, size_t last, vector<SubsetSum> &sums) {
+		const auto &items = this->knapsack.GetItems();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+
+		sums.assign(1, SubsetSum{ 0, 0, 0 });
+		for (auto i = first; i < last; ++i) {
+			const auto &currentItem = items[i];
+			if (currentItem.weight > maxWeight)continue;
+			auto bit = uint64_t(1) << (i - first);
+
+			// merges the sums without and with the item, both sorted by weight
+			this->mergedSums.clear();
+			size_t without = 0, with = 0;
+			while (without < sums.size() || with < sums.size()) {
+				SubsetSum next;
+				bool hasWith = with < sums.size() && sums[with].weight <= maxWeight - currentItem.weight;
+				if (!hasWith && without >= sums.size())break;
+				if (hasWith && (without >= sums.size() || sums[with].weight + currentItem.weight < sums[without].weight)) {
+					next.weight = sums[with].weight + currentItem.weight;
+					next.price = sums[with].price + currentItem.price;
+					next.choice = sums[with].choice | bit;
+					++with;
+				}
+				else {
+					next = sums[without++];
+				}
+
+				// keeps the weights and prices strictly increasing
+				if (!this->mergedSums.empty()) {
+					auto &previous = this->mergedSums.back();
+					if (next.price <= previous.price)continue;
+					if (next.weight == previous.weight) {
+						previous = next;
+						continue;
+					}
+				}
+				this->mergedSums.push_back(next);
+			}
+			sums.swap(this->mergedSums);
+		}
+	}
+
+	// stores the node in the pool and optionally opens it, returns its index
+	template<typename BoundLess>
+	uint32_t PushNode(const SearchNode &node, bool isOpen, BoundLess &boundLess) {
+		auto index = (uint32_t)this->nodePool.size();
+		if (index == noNode)throw runtime_error{ "too many search nodes" };
+		this->nodePool.push_back(node);
+		if (isOpen) {
+			this->openNodes.push_back(index);
+			push_heap(this->openNodes.begin(), this->openNodes.end(), boundLess);
+		}
+		return index;
+	}
+
+	/*
+		weight * prices[index] / weights[index], rounded down or up to an
+		integer if the prices are integers. With integral weights and prices
+		it is computed exactly on the product type, and otherwise from the
+		ratio column.
+	*/
+	PriceType GetFractionalPrice(WeightType weight, size_t index, bool isRoundedUp) const {
+		using IsExact = integral_constant<bool, is_integral<WeightType>::value && is_integral<PriceType>::value>;
+		// items of zero weight are sorted first unless they are empty,
+		// so after the critical item they are worth nothing
+		if (this->weights[index] == 0)return 0;
+		return this->GetFractionalPrice(weight, index, isRoundedUp, IsExact{});
+	}
+
+	PriceType GetFractionalPrice(WeightType weight, size_t index, bool isRoundedUp, true_type) const {
+		using ProductType = typename KnapsackProductType<WeightType, PriceType>::Type;
+		auto product = (ProductType)weight * (ProductType)this->prices[index];
+		auto divisor = (ProductType)this->weights[index];
+		if (isRoundedUp)product += divisor - 1;
+		return (PriceType)(product / divisor);
+	}
+
+	PriceType GetFractionalPrice(WeightType weight, size_t index, bool isRoundedUp, false_type) const {
+		auto value = (FPType)weight * this->ratios[index];
+		return isRoundedUp ? CeilPrice(value) : FloorPrice(value);
+	}
+
+	// rounds a fractional price bound down, if prices are integers
+	static PriceType FloorPrice(FPType value) {
+		return is_integral<PriceType>::value ? (PriceType)floor(value) : (PriceType)value;
+	}
+
+	static PriceType CeilPrice(FPType value) {
+		return is_integral<PriceType>::value ? (PriceType)ceil(value) : (PriceType)value;
+	}
+
+	/*
+		The Martello-Toth bound U2 of the subproblem where items [0, depth)
+		are decided. With the critical item s (the first item of the greedy
+		fill that does not fit) and the capacity r left before it:
+		- U0 assumes s is not taken and fills r with the ratio of item s + 1;
+		- U1 assumes s is taken and removes the overflow with the ratio of s - 1.
+		U2 = max(U0, U1). Make sure that the item container is sorted
+		according to the price / weight ratio and that BuildColumns() has
+		been called.
+	*/
+	PriceType GetMartelloTothBound(size_t depth, WeightType weight, PriceType price) const {
+		this->statistics.OnBoundEvaluated();
+		auto numOfItems = this->weights.size();
+		WeightType weightLeft = this->knapsack.GetMaxWeight() - weight;
+		auto critical = this->FindCriticalItem(depth, weightLeft);
+
+		price += (PriceType)(this->prefixPrices[critical] - this->prefixPrices[depth]);
+		if (critical >= numOfItems)return price;
+		weightLeft -= (WeightType)(this->prefixWeights[critical] - this->prefixWeights[depth]);
+
+		PriceType bound = price;
+		if (critical + 1 < numOfItems) {
+			bound = price + this->GetFractionalPrice(weightLeft, critical + 1, false);
+		}
+		// an item of zero weight before s would make U1 minus infinity
+		if (critical > depth && this->weights[critical - 1] > 0) {
+			WeightType overflow = this->weights[critical] - weightLeft;
+			PriceType takenPrice = price + this->prices[critical];
+			PriceType penalty = this->GetFractionalPrice(overflow, critical - 1, true);
+			// U1 below zero only means that s is not worth taking, and it
+			// would wrap around for unsigned prices, so it is skipped
+			if (penalty < takenPrice)bound = max(bound, (PriceType)(takenPrice - penalty));
+		}
+		return bound;
+	}
+
+	/*
+		The capacity the DP over the capacity works up to. It is clamped to the
+		total weight of the items which fit, so a huge capacity does not size
+		a huge table, and is 0 for a negative capacity, where nothing fits.
+	*/
+	uint64_t GetDPCapacity() const {
+		auto maxWeight = this->knapsack.GetMaxWeight();
+		if (IsNegative(maxWeight))return 0;
+		const auto maxTotal = numeric_limits<uint64_t>::max();
+		uint64_t total = 0;
+		for (const auto &currentItem : this->knapsack.GetItems()) {
+			if (currentItem.weight > maxWeight || IsNegative(currentItem.weight))continue;
+			auto weight = (uint64_t)currentItem.weight;
+			total = (total > maxTotal - weight) ? maxTotal : total + weight;
+		}
+		return min((uint64_t)maxWeight, total);
+	}
+
+	// the width of the DP table over the capacity, saturated
+	uint64_t GetWeightDPWidth(true_type) const {
+		auto capacity = this->GetDPCapacity();
+		return capacity == numeric_limits<uint64_t>::max() ? capacity : capacity + 1;
+	}
+
+	uint64_t GetWeightDPWidth(false_type) const {
+		return numeric_limits<uint64_t>::max();
+	}
+
+	// the width of the DP table over the total price
+	uint64_t GetProfitDPWidth(true_type) const {
+		uint64_t total = 0;
+		for (const auto &currentItem : this->knapsack.GetItems()) {
+			if (currentItem.weight <= this->knapsack.GetMaxWeight() && currentItem.price > 0)
+				total += (uint64_t)currentItem.price;
+		}
+		return total + 1;
+	}
+
+	uint64_t GetProfitDPWidth(false_type) const {
+		return numeric_limits<uint64_t>::max();
+	}
+
+	ItemContainerType GetBestItems() const {
 		ItemContainerType result;
 		for (auto i = 0U; i < this->bestChoice.size(); ++i) {
 			if (this->bestChoice[i])
@@ -136,15 +1068,15 @@ public:
 		return result;
 	}
 
-private:
-
 	void Init() {
 		this->currentPrice = 0;
 		this->currentWeight = 0;
 		this->bestPrice = 0;
+		this->numOfExpandedNodes = 0;
+		this->statistics.Reset();
 
-		this->choice.clear();
-		this->bestChoice.clear();
+		this->choice.assign(this->knapsack.GetItems().size(), false);
+		this->bestChoice.assign(this->knapsack.GetItems().size(), false);
 	}
 
 	void BacktrackDirect(size_t depth) {
@@ -153,8 +1085,9 @@ private:
 		}
 
 		const auto &currentItem = this->knapsack.GetItems()[depth];
+		this->statistics.OnNodeVisited(depth);
 
-		if (this->currentWeight + currentItem.weight <= this->knapsack.GetMaxWeight()) {
+		if (currentItem.weight <= this->knapsack.GetMaxWeight() - this->currentWeight) {
 			// select the current item
 			this->currentWeight += currentItem.weight;
 			this->currentPrice += currentItem.price;
@@ -162,6 +1095,7 @@ private:
 
 			if (this->currentPrice > this->bestPrice) {
 				this->bestPrice = this->currentPrice;
+				this->statistics.OnIncumbentImproved((double)this->bestPrice);
 				copy(this->choice.begin(), this->choice.end(), this->bestChoice.begin());
 			}
 
@@ -172,67 +1106,136 @@ private:
 			this->currentPrice -= currentItem.price;
 			this->choice[depth] = false;
 		}
+		else {
+			this->statistics.OnPruned(KnapsackPruneReason::Capacity);
+		}
 
 		this->BacktrackDirect(depth + 1);
 	}
 
-	void BacktrackSorted(size_t depth) {
-		if (depth >= this->choice.size()) {
-			return;
-		}
+	/*
+		The same search as BacktrackDirect() over the sorted items, with an
+		explicit stack instead of recursion. The stack holds the taken items
+		of the current path, so backtracking pops the last taken item and goes
+		on with its "skip" branch, and nothing is left on the stack for the
+		items that were skipped.
+		The incumbent is kept in the same form. Its first sharedLength items
+		are also the bottom of the current stack, so an improvement only
+		rewrites the items pushed since then instead of copying a whole
+		choice vector.
+	*/
+	void BacktrackSorted() {
+		auto numOfItems = this->weights.size();
+		auto maxWeight = this->knapsack.GetMaxWeight();
 
-		const auto &currentItem = this->knapsack.GetItems()[depth];
+		// reserved once, the search itself never allocates
+		this->takenItems.clear();
+		this->takenItems.reserve(numOfItems);
+		this->bestTakenItems.clear();
+		this->bestTakenItems.reserve(numOfItems);
+		size_t sharedLength = 0;
 
-		if (this->currentWeight + currentItem.weight <= this->knapsack.GetMaxWeight()) {
-			// select the current item
-			this->currentWeight += currentItem.weight;
-			this->currentPrice += currentItem.price;
-			this->choice[depth] = true;
+		size_t depth = 0;
+		while (true) {
+			if (depth < numOfItems) {
+				++this->numOfExpandedNodes;
+				this->statistics.OnNodeVisited(depth);
 
-			if (this->currentPrice > this->bestPrice) {
-				this->bestPrice = this->currentPrice;
-				copy(this->choice.begin(), this->choice.end(), this->bestChoice.begin());
-			}
+				// the current weight never exceeds maxWeight, so unlike the
+				// sum, the subtraction cannot wrap
+				if (this->weights[depth] <= maxWeight - this->currentWeight) {
+					// select the current item and enter next layer
+					this->currentWeight += this->weights[depth];
+					this->currentPrice += this->prices[depth];
+					this->takenItems.push_back(depth);
 
-			// enter next layer
-			this->BacktrackSorted(depth + 1);
+					if (this->currentPrice > this->bestPrice) {
+						this->bestPrice = this->currentPrice;
+						this->statistics.OnIncumbentImproved((double)this->bestPrice);
+						this->bestTakenItems.resize(this->takenItems.size());
+						copy(this->takenItems.begin() + sharedLength, this->takenItems.end(),
+							this->bestTakenItems.begin() + sharedLength);
+						sharedLength = this->takenItems.size();
+					}
 
-			this->currentWeight -= currentItem.weight;
-			this->currentPrice -= currentItem.price;
-			this->choice[depth] = false;
-		}
+					++depth;
+					continue;
+				}
 
-		if (this->GetPriceUpperBound(depth + 1) > bestPrice)
-			this->BacktrackSorted(depth + 1);
-	}
+				// the item does not fit, so only the "skip" branch is left
+				this->statistics.OnPruned(KnapsackPruneReason::Capacity);
+				if (this->GetPriceUpperBound(depth + 1) > this->bestPrice) {
+					++depth;
+					continue;
+				}
+				this->statistics.OnPruned(KnapsackPruneReason::Bound);
+			}
 
-	// make sure that the item conatiner is sorted according to 
-	// the price / weight ratio
-	PriceType GetPriceUpperBound(size_t depth) const {
-		PriceType maxPrice = currentPrice;
-		WeightType newWeight = currentWeight;
-		while (depth < this->knapsack.GetItems().size()) {
-			const auto &currentItem = this->knapsack.GetItems()[depth];
-			WeightType testWeight = currentItem.weight + newWeight;
+			// backtrack to the last taken item which is worth skipping
+			bool isResumed = false;
+			while (!this->takenItems.empty()) {
+				auto last = this->takenItems.back();
+				this->takenItems.pop_back();
+				if (sharedLength > this->takenItems.size())sharedLength = this->takenItems.size();
 
-			if (testWeight > this->knapsack.GetMaxWeight())break;
+				this->currentWeight -= this->weights[last];
+				this->currentPrice -= this->prices[last];
 
-			newWeight = testWeight;
-			maxPrice += currentItem.price;
-			++depth;
+				if (this->GetPriceUpperBound(last + 1) > this->bestPrice) {
+					depth = last + 1;
+					isResumed = true;
+					break;
+				}
+				this->statistics.OnPruned(KnapsackPruneReason::Bound);
+			}
+			if (!isResumed)break;
 		}
 
-		// if not all items can be put in, just fill the knapsack
-		// according to the maximum price / weight ratio to get an
-		// upperbound of price
-		if (depth < this->knapsack.GetItems().size()) {
-			using FPType = typename ItemType::FPType;
-			const auto &currentItem = this->knapsack.GetItems()[depth];
-			WeightType weightLeft = this->knapsack.GetMaxWeight() - newWeight;
-			maxPrice += (PriceType)round((FPType)weightLeft * currentItem.GetPriceWeightRatio());
+		for (auto index : this->bestTakenItems)this->bestChoice[index] = true;
+	}
+
+	/*
+		Copies the sorted items into contiguous columns, so that the search
+		only reads the fields it needs and never goes through the item
+		container. The ratios are computed once here.
+		prefixWeights[i] and prefixPrices[i] are the totals of items [0, i),
+		summed in SumType so that they stay sorted instead of wrapping.
+	*/
+	void BuildColumns() {
+		const auto &items = this->knapsack.GetItems();
+		this->weights.clear();
+		this->prices.clear();
+		this->ratios.clear();
+		this->prefixWeights.assign(1, 0);
+		this->prefixPrices.assign(1, 0);
+		for (const auto &currentItem : items) {
+			this->weights.push_back(currentItem.weight);
+			this->prices.push_back(currentItem.price);
+			this->ratios.push_back(currentItem.GetPriceWeightRatio());
+			this->prefixWeights.push_back(this->prefixWeights.back() + (SumType)currentItem.weight);
+			this->prefixPrices.push_back(this->prefixPrices.back() + (SumType)currentItem.price);
 		}
+	}
 
-		return maxPrice;
+	/*
+		The greedy fill from depth takes a run of items until the first one
+		that does not fit, the critical item. The prefix sums are sorted, so
+		it is found by binary search in O(log n). Returns the number of items
+		if they all fit.
+	*/
+	size_t FindCriticalItem(size_t depth, WeightType capacityLeft) const {
+		auto baseWeight = this->prefixWeights[depth];
+		// the first prefix which does not fit is prefixWeights[critical + 1]
+		auto end = upper_bound(this->prefixWeights.begin() + depth + 1, this->prefixWeights.end(), (SumType)capacityLeft,
+			[baseWeight](SumType capacity, SumType prefix) { return capacity < prefix - baseWeight; });
+		return (size_t)(end - this->prefixWeights.begin()) - 1;
+	}
+
+	// make sure that the item container is sorted according to
+	// the price / weight ratio and that BuildColumns() has been called
+	PriceType GetPriceUpperBound(size_t depth) const {
+		this->statistics.OnBoundEvaluated();
+		return this->GetPriceUpperBound(depth, this->currentWeight, this->currentPrice);
 	}
 
 private:
@@ -241,6 +1244,31 @@ private:
 	WeightType currentWeight{ 0 };
 	vector<bool> choice;
 	vector<bool> bestChoice;
+	// the search stack of BacktrackSorted() and the incumbent in the same form
+	vector<size_t> takenItems;
+	vector<size_t> bestTakenItems;
+	// the sorted items as columns, see BuildColumns()
+	vector<WeightType> weights;
+	vector<PriceType> prices;
+	vector<FPType> ratios;
+	vector<SumType> prefixWeights;
+	vector<SumType> prefixPrices;
+	// the rolling arrays of the DPs and whether item i was taken to
+	// reach the DP cell, one row per item
+	vector<PriceType> dpPrices;
+	vector<WeightType> dpWeights;
+	BitMatrix decisions;
+	uint64_t maxDPCells{ defaultMaxDPCells };
+	size_t numOfExpandedNodes{ 0 };
+	// mutable, as the bound functions count their evaluations
+	mutable StatisticsType statistics;
+	// the nodes of BestFirstSolve() and the heap of open node indices
+	vector<SearchNode> nodePool;
+	vector<uint32_t> openNodes;
+	// the subset sums of MeetInTheMiddleSolve() and a buffer to merge them
+	vector<SubsetSum> leftSums;
+	vector<SubsetSum> rightSums;
+	vector<SubsetSum> mergedSums;
 
 private:
 	KnapsackType &knapsack;
@@ -0,0 +1,380 @@
+#ifndef DEF_KNAPSACKPREPROCESS_HPP
+#define DEF_KNAPSACKPREPROCESS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Knapsack.hpp"
+
+using namespace std;
+
+/*
+	Shrinks a knapsack before it is solved, and maps the solution of the
+	smaller knapsack back to the original items. The reduction
+	- drops the items that are heavier than the knapsack or worth nothing,
+	  and takes the weightless ones;
+	- groups equal items, which are interchangeable;
+	- drops the copies of an item that are dominated by lighter and
+	  dearer items, when all those items and the copy cannot fit together:
+	  any solution with the copy then misses one of them, which is at
+	  least as good in its place. The weights of the items kept so far
+	  are summed per price in a Fenwick tree, so it takes O(n log n);
+	- fixes the items whose Dembo-Hammer bound, flipped from the LP
+	  solution, cannot beat the greedy solution, the same test as
+	  CoreKnapsackSolver's;
+	- splits the copies of each group left free into bundles of 1, 2, 4,
+	  ... copies, so m equal items become O(log m) items of the reduced
+	  knapsack.
+	The greedy solution is kept, and is the answer whenever the reduced
+	knapsack cannot beat it. Weights and prices have to be integers.
+*/
+template<typename WeightT, typename PriceT, typename ItemContainerT = vector<Item<WeightT, PriceT>>>
+class KnapsackPreprocessor {
+public:
+	using KnapsackType = Knapsack<WeightT, PriceT, ItemContainerT>;
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using ItemType = Item<WeightType, PriceType>;
+	using ItemContainerType = typename KnapsackType::ItemContainerType;
+	using ProductType = typename KnapsackProductType<WeightType, PriceType>::Type;
+	using ReducedKnapsackType = Knapsack<WeightType, PriceType>;
+	using ReducedSolverType = typename ReducedKnapsackType::KnapsackSolverType;
+
+	static_assert(is_integral<WeightType>::value && is_integral<PriceType>::value,
+		"KnapsackPreprocessor requires integral weights and prices");
+
+	KnapsackPreprocessor(KnapsackType &_knapsack) :knapsack{ _knapsack } {}
+
+	// builds GetReducedKnapsack(), without changing the original knapsack
+	void Reduce() {
+		const auto &items = this->knapsack.GetItems();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+
+		this->order.clear();
+		this->takenItems.clear();
+		this->numOfRemovedItems = 0;
+		for (size_t i = 0; i < items.size(); ++i) {
+			const auto &currentItem = items.at(i);
+			if (currentItem.weight > maxWeight || currentItem.price <= 0)++this->numOfRemovedItems;
+			else if (currentItem.weight == 0)this->takenItems.push_back(i);
+			else this->order.push_back(i);
+		}
+
+		this->GroupEqualItems();
+		this->RemoveDominatedItems();
+		this->FixItems();
+		this->BuildReducedKnapsack();
+	}
+
+	/*
+		Reduces the knapsack and solves the reduced one with solve, which is
+		given the solver of the reduced knapsack and returns its chosen
+		items, for example [](auto &solver) { return solver.DPSolve(); }.
+		Returns the chosen items of the original knapsack, in their order.
+	*/
+	template<typename SolveFunctionT>
+	ItemContainerType Solve(SolveFunctionT solve) {
+		this->Reduce();
+
+		for (auto &group : this->groups)group.numOfChosenCopies = group.numOfFixedCopies;
+		PriceType reducedPrice = this->fixedPrice;
+		if (!this->bundles.empty()) {
+			ReducedSolverType solver{ this->reducedKnapsack };
+			auto chosen = solve(solver);
+			reducedPrice += this->MatchBundles(chosen);
+		}
+
+		// the greedy solution wins ties, as the fixing only keeps better solutions
+		if (reducedPrice <= this->greedyPrice) {
+			for (auto &group : this->groups)group.numOfChosenCopies = group.numOfGreedyCopies;
+		}
+
+		this->originalChoice.assign(this->knapsack.GetItems().size(), false);
+		for (auto index : this->takenItems)this->originalChoice[index] = true;
+		for (const auto &group : this->groups) {
+			for (size_t i = 0; i < group.numOfChosenCopies; ++i)this->originalChoice[this->order[group.first + i]] = true;
+		}
+
+		ItemContainerType result;
+		for (size_t i = 0; i < this->originalChoice.size(); ++i) {
+			if (this->originalChoice[i])result.push_back(this->knapsack.GetItems().at(i));
+		}
+		return result;
+	}
+
+	// solves the reduced knapsack with KnapsackSolver::Solve()
+	ItemContainerType Solve() {
+		return this->Solve([](ReducedSolverType &solver) { return solver.Solve(); });
+	}
+
+	// the knapsack left by the last Reduce(), of bundles of equal items
+	const ReducedKnapsackType &GetReducedKnapsack() const { return this->reducedKnapsack; }
+	// whether each original item is in the solution of the last Solve()
+	const vector<bool> &GetOriginalChoice() const { return this->originalChoice; }
+	// the items which can never be in a better solution
+	size_t GetNumOfRemovedItems() const { return this->numOfRemovedItems; }
+	// the items decided without a search, taken or left out
+	size_t GetNumOfFixedItems() const { return this->numOfFixedItems; }
+
+private:
+	// equal items, order[first, last) are their original indices
+	struct ItemGroup {
+		WeightType weight;
+		PriceType price;
+		size_t first;
+		size_t last;
+		// the copies which survive the dominance test
+		size_t numOfKeptCopies;
+		// the copies taken by the LP solution, the greedy solution,
+		// the fixing and the final solution
+		size_t numOfLPCopies;
+		size_t numOfGreedyCopies;
+		size_t numOfFixedCopies;
+		size_t numOfChosenCopies;
+	};
+
+	// an item of the reduced knapsack, count copies of a group
+	struct Bundle {
+		WeightType weight;
+		PriceType price;
+		size_t group;
+		size_t count;
+	};
+
+	// sorts the items by weight, then by price from the highest, and groups equal ones
+	void GroupEqualItems() {
+		const auto &items = this->knapsack.GetItems();
+		sort(this->order.begin(), this->order.end(), [&items](size_t left, size_t right) {
+			const auto &leftItem = items.at(left);
+			const auto &rightItem = items.at(right);
+			if (leftItem.weight != rightItem.weight)return leftItem.weight < rightItem.weight;
+			if (leftItem.price != rightItem.price)return leftItem.price > rightItem.price;
+			return left < right;
+		});
+
+		this->groups.clear();
+		for (size_t i = 0; i < this->order.size(); ++i) {
+			const auto &currentItem = items.at(this->order[i]);
+			if (this->groups.empty() || this->groups.back().weight != currentItem.weight
+				|| this->groups.back().price != currentItem.price) {
+				ItemGroup group{};
+				group.weight = currentItem.weight;
+				group.price = currentItem.price;
+				group.first = i;
+				this->groups.push_back(group);
+			}
+			this->groups.back().last = i + 1;
+		}
+	}
+
+	/*
+		The groups come lightest first and, at the same weight, dearest
+		first, so the items which dominate a group have all been seen before
+		it: they are the kept items with a price at least the group's, whose
+		weights the Fenwick tree sums. The k-th copy of the group is kept if
+		those items and k copies fit together.
+	*/
+	void RemoveDominatedItems() {
+		auto maxWeight = (ProductType)this->knapsack.GetMaxWeight();
+
+		// the ranks of the prices from the highest
+		this->priceRanks.clear();
+		for (const auto &group : this->groups)this->priceRanks.push_back(group.price);
+		sort(this->priceRanks.begin(), this->priceRanks.end(), greater<PriceType>{});
+		this->priceRanks.erase(unique(this->priceRanks.begin(), this->priceRanks.end()), this->priceRanks.end());
+		this->keptWeights.assign(this->priceRanks.size() + 1, 0);
+
+		for (auto &group : this->groups) {
+			auto rank = (size_t)(lower_bound(this->priceRanks.begin(), this->priceRanks.end(), group.price,
+				greater<PriceType>{}) - this->priceRanks.begin());
+			auto dominatingWeight = this->GetKeptWeight(rank + 1);
+			auto numOfCopies = group.last - group.first;
+			group.numOfKeptCopies = 0;
+			if (dominatingWeight < maxWeight) {
+				auto numOfFitting = (maxWeight - dominatingWeight) / (ProductType)group.weight;
+				group.numOfKeptCopies = (size_t)min((ProductType)numOfCopies, numOfFitting);
+			}
+			this->numOfRemovedItems += numOfCopies - group.numOfKeptCopies;
+			this->AddKeptWeight(rank + 1, (ProductType)group.numOfKeptCopies * (ProductType)group.weight);
+		}
+	}
+
+	// the Fenwick tree over the price ranks, indexed from 1
+	void AddKeptWeight(size_t rank, ProductType weight) {
+		for (; rank < this->keptWeights.size(); rank += rank & (~rank + 1))this->keptWeights[rank] += weight;
+	}
+
+	// the kept weight of the price ranks [1, rank]
+	ProductType GetKeptWeight(size_t rank) const {
+		ProductType weight{ 0 };
+		for (; rank > 0; rank -= rank & (~rank + 1))weight += this->keptWeights[rank];
+		return weight;
+	}
+
+	/*
+		Orders the kept groups by price / weight ratio and fills the LP and
+		greedy solutions copy by copy. The break item is the first copy the
+		LP solution does not take. Then every run of copies on one side of
+		it is fixed if flipping it cannot beat the greedy solution, see
+		CoreKnapsackSolver::CanFixAsTaken() for the test.
+	*/
+	void FixItems() {
+		const auto &items = this->knapsack.GetItems();
+		auto maxWeight = this->knapsack.GetMaxWeight();
+
+		this->ratioOrder.clear();
+		for (size_t i = 0; i < this->groups.size(); ++i) {
+			if (this->groups[i].numOfKeptCopies > 0)this->ratioOrder.push_back(i);
+		}
+		sort(this->ratioOrder.begin(), this->ratioOrder.end(), [this](size_t left, size_t right) {
+			const auto &leftGroup = this->groups[left];
+			const auto &rightGroup = this->groups[right];
+			return (ProductType)leftGroup.price * (ProductType)rightGroup.weight
+				> (ProductType)rightGroup.price * (ProductType)leftGroup.weight;
+		});
+
+		this->fixedPrice = 0;
+		for (auto index : this->takenItems)this->fixedPrice += items.at(index).price;
+		this->greedyPrice = this->fixedPrice;
+		this->numOfFixedItems = this->takenItems.size();
+
+		WeightType lpWeight{ 0 };
+		PriceType lpPrice{ 0 };
+		const ItemGroup *breakGroup = nullptr;
+		WeightType greedyWeight{ 0 };
+		for (auto index : this->ratioOrder) {
+			auto &group = this->groups[index];
+			auto numOfFitting = (size_t)((maxWeight - greedyWeight) / group.weight);
+			group.numOfGreedyCopies = min(group.numOfKeptCopies, numOfFitting);
+			group.numOfLPCopies = (breakGroup == nullptr) ? group.numOfGreedyCopies : 0;
+			greedyWeight += (WeightType)group.numOfGreedyCopies * group.weight;
+			this->greedyPrice += (PriceType)group.numOfGreedyCopies * group.price;
+			if (breakGroup == nullptr) {
+				lpWeight += (WeightType)group.numOfLPCopies * group.weight;
+				lpPrice += (PriceType)group.numOfLPCopies * group.price;
+				if (group.numOfLPCopies < group.numOfKeptCopies)breakGroup = &group;
+			}
+		}
+
+		// all the kept items fit, which is the solution
+		if (breakGroup == nullptr) {
+			for (auto &group : this->groups) {
+				group.numOfFixedCopies = group.numOfKeptCopies;
+				this->numOfFixedItems += group.numOfKeptCopies;
+				this->fixedPrice += (PriceType)group.numOfKeptCopies * group.price;
+			}
+			return;
+		}
+
+		/*
+			Flipping a copy j is hopeless if U - |p_j - w_j * p_b / w_b| < g + 1,
+			with U the LP bound and g the greedy price. Multiplied by w_b and
+			with the terms moved around, every side is a sum of products which
+			are never negative, so unsigned types do not wrap.
+		*/
+		auto bound = ((ProductType)this->fixedPrice + (ProductType)lpPrice) * (ProductType)breakGroup->weight
+			+ (ProductType)(maxWeight - lpWeight) * (ProductType)breakGroup->price;
+		auto greedyBound = ((ProductType)this->greedyPrice + 1) * (ProductType)breakGroup->weight;
+		for (auto &group : this->groups) {
+			auto groupProduct = (ProductType)group.price * (ProductType)breakGroup->weight;
+			auto breakProduct = (ProductType)breakGroup->price * (ProductType)group.weight;
+			group.numOfFixedCopies = 0;
+			if (group.numOfLPCopies > 0 && bound + breakProduct < greedyBound + groupProduct) {
+				group.numOfFixedCopies = group.numOfLPCopies;
+				this->numOfFixedItems += group.numOfLPCopies;
+				this->fixedPrice += (PriceType)group.numOfLPCopies * group.price;
+			}
+			// the copies left out are fixed by dropping them from the free copies
+			if (group.numOfKeptCopies > group.numOfLPCopies && bound + groupProduct < greedyBound + breakProduct) {
+				this->numOfFixedItems += group.numOfKeptCopies - group.numOfLPCopies;
+				group.numOfKeptCopies = group.numOfLPCopies;
+			}
+		}
+	}
+
+	// splits the copies left free into bundles of 1, 2, 4, ... copies
+	void BuildReducedKnapsack() {
+		WeightType capacity = this->knapsack.GetMaxWeight();
+		for (auto index : this->takenItems)capacity -= this->knapsack.GetItems().at(index).weight;
+
+		this->bundles.clear();
+		auto &reducedItems = this->reducedKnapsack.GetItems();
+		reducedItems.clear();
+		for (size_t i = 0; i < this->groups.size(); ++i) {
+			const auto &group = this->groups[i];
+			capacity -= (WeightType)group.numOfFixedCopies * group.weight;
+			auto numOfFreeCopies = group.numOfKeptCopies - group.numOfFixedCopies;
+			for (size_t count = 1; numOfFreeCopies > 0; count *= 2) {
+				auto bundleCount = min(count, numOfFreeCopies);
+				numOfFreeCopies -= bundleCount;
+				Bundle bundle;
+				bundle.weight = (WeightType)bundleCount * group.weight;
+				bundle.price = (PriceType)bundleCount * group.price;
+				bundle.group = i;
+				bundle.count = bundleCount;
+				this->bundles.push_back(bundle);
+				ItemType reducedItem;
+				reducedItem.weight = bundle.weight;
+				reducedItem.price = bundle.price;
+				reducedItems.push_back(reducedItem);
+			}
+		}
+		this->reducedKnapsack.SetMaxWeight(capacity);
+	}
+
+	/*
+		The solvers return the chosen items rather than their positions, and
+		may sort the reduced knapsack, but equal bundles are interchangeable,
+		so they are matched back by sorting both by weight and price.
+		Returns the price of the chosen bundles.
+	*/
+	template<typename ChosenContainerT>
+	PriceType MatchBundles(ChosenContainerT &chosen) {
+		auto itemLess = [](WeightType leftWeight, PriceType leftPrice, WeightType rightWeight, PriceType rightPrice) {
+			return leftWeight < rightWeight || (leftWeight == rightWeight && leftPrice < rightPrice);
+		};
+		sort(chosen.begin(), chosen.end(), [&itemLess](const ItemType &left, const ItemType &right) {
+			return itemLess(left.weight, left.price, right.weight, right.price);
+		});
+		sort(this->bundles.begin(), this->bundles.end(), [&itemLess](const Bundle &left, const Bundle &right) {
+			return itemLess(left.weight, left.price, right.weight, right.price);
+		});
+
+		PriceType price{ 0 };
+		auto bundleIter = this->bundles.begin();
+		for (const auto &chosenItem : chosen) {
+			while (itemLess(bundleIter->weight, bundleIter->price, chosenItem.weight, chosenItem.price))++bundleIter;
+			this->groups[bundleIter->group].numOfChosenCopies += bundleIter->count;
+			price += chosenItem.price;
+			++bundleIter;
+		}
+		return price;
+	}
+
+	KnapsackType &knapsack;
+
+	// the indices of the items that may be useful, grouped by GroupEqualItems()
+	vector<size_t> order;
+	// the weightless items, always taken
+	vector<size_t> takenItems;
+	vector<ItemGroup> groups;
+	// the distinct prices and the Fenwick tree of RemoveDominatedItems()
+	vector<PriceType> priceRanks;
+	vector<ProductType> keptWeights;
+	// the kept groups by price / weight ratio
+	vector<size_t> ratioOrder;
+
+	PriceType fixedPrice{ 0 };
+	PriceType greedyPrice{ 0 };
+	vector<Bundle> bundles;
+	ReducedKnapsackType reducedKnapsack;
+	vector<bool> originalChoice;
+
+	size_t numOfRemovedItems{ 0 };
+	size_t numOfFixedItems{ 0 };
+};
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef DEF_PARALLELKNAPSACK_HPP
+#define DEF_PARALLELKNAPSACK_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <bitset>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+
+#include "../Common/ParallelRandom.hpp"
+#include "Knapsack.hpp"
+
+using namespace std;
+
+/*
+	Branch and bound over the items sorted by price / weight ratio, run by
+	a pool of threads which is started with the solver and reused by every
+	Solve(). The thread calling Solve() works as one of them.
+
+	A task is the root of a subtree: the next item to decide, the weight and
+	price so far and the decisions made (a bitset, so tasks never allocate).
+	Every worker owns a deque of tasks. It searches its own tasks depth first
+	from the back, and while its deque is short it splits off the "skip the
+	item" branch of shallow nodes as new tasks. Idle workers steal from the
+	front of other deques, where the largest subtrees are, and sleep on a
+	condition variable while there is nothing to steal.
+
+	The best price is a lock-free atomic shared by all workers, so a new
+	incumbent prunes in every thread at once. The winner of the atomic update
+	then copies its decision bitset under a mutex, which only happens when
+	the incumbent improves. Subtrees are pruned by the exact Dantzig bound
+	of KnapsackSolver, read from its columns.
+*/
+template<typename WeightT, typename PriceT, typename ItemContainerT = vector<Item<WeightT, PriceT>>>
+class ParallelKnapsackSolver {
+public:
+	using KnapsackType = Knapsack<WeightT, PriceT, ItemContainerT>;
+	using WeightType = WeightT;
+	using PriceType = PriceT;
+	using ItemType = Item<WeightType, PriceType>;
+	using ItemContainerType = typename KnapsackType::ItemContainerType;
+
+	// the largest number of items, exhaustive search is hopeless long before this
+	static constexpr size_t maxNumOfItems = 256;
+	using ChoiceType = bitset<maxNumOfItems>;
+
+	// subtrees with fewer undecided items than this are never split
+	static constexpr size_t minSplitSize = 12;
+	// a worker splits off tasks while it has fewer queued than this
+	static constexpr size_t maxQueuedTasks = 4;
+
+	ParallelKnapsackSolver(KnapsackType &_knapsack, size_t _numOfThreads = thread::hardware_concurrency()) :
+		knapsack{ _knapsack }, numOfThreads{ _numOfThreads == 0 ? 1 : _numOfThreads }, boundSolver{ _knapsack } {
+		this->workers.resize(this->numOfThreads);
+		for (size_t i = 0; i < this->numOfThreads; ++i) {
+			SeedRandomStream(this->workers[i].randomEngine, Xoshiro256StarStar::default_seed, i);
+		}
+		for (size_t i = 1; i < this->numOfThreads; ++i) {
+			this->poolThreads.emplace_back(&ParallelKnapsackSolver::PoolLoop, this, i);
+		}
+	}
+
+	~ParallelKnapsackSolver() {
+		{
+			lock_guard<mutex> lock{ this->poolMutex };
+			this->isStopping = true;
+		}
+		this->searchStarted.notify_all();
+		for (auto &poolThread : this->poolThreads)poolThread.join();
+	}
+
+	// this method will sort the knapsack item container
+	ItemContainerType Solve() {
+		const auto &items = this->knapsack.GetItems();
+		if (items.size() > maxNumOfItems)throw runtime_error{ "too many items for the parallel solver" };
+		this->boundSolver.PrepareColumns();
+
+		// a private copy of the columns the search reads
+		this->weights.clear();
+		this->prices.clear();
+		for (const auto &currentItem : items) {
+			this->weights.push_back(currentItem.weight);
+			this->prices.push_back(currentItem.price);
+		}
+		this->maxWeight = this->knapsack.GetMaxWeight();
+
+		this->bestPrice.store(0);
+		this->bestChoice.reset();
+		this->bestChoicePrice = 0;
+		this->numOfExpandedNodes.store(0);
+		for (auto &worker : this->workers) {
+			worker.tasks.clear();
+			worker.numOfExpandedNodes = 0;
+		}
+
+		Task root;
+		this->workers[0].tasks.push_back(root);
+		this->numOfQueuedTasks.store(1);
+		this->numOfPendingTasks.store(1);
+
+		// wake the pool for this search, then wait until every thread is done with it
+		{
+			lock_guard<mutex> lock{ this->poolMutex };
+			this->numOfRunningThreads = this->poolThreads.size();
+			++this->searchNumber;
+		}
+		this->searchStarted.notify_all();
+		this->WorkerLoop(0);
+		{
+			unique_lock<mutex> lock{ this->poolMutex };
+			this->searchFinished.wait(lock, [this]() { return this->numOfRunningThreads == 0; });
+		}
+
+		ItemContainerType result;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (this->bestChoice[i])result.push_back(items.at(i));
+		}
+		return result;
+	}
+
+	size_t GetNumOfThreads() const { return this->numOfThreads; }
+	size_t GetNumOfExpandedNodes() const { return this->numOfExpandedNodes.load(); }
+
+private:
+	struct Task {
+		size_t depth{ 0 };
+		WeightType weight{ 0 };
+		PriceType price{ 0 };
+		ChoiceType choice;
+	};
+
+	struct Worker {
+		mutex tasksMutex;
+		deque<Task> tasks;
+		// counted locally and summed once at the end
+		size_t numOfExpandedNodes{ 0 };
+		// picks the first victim to steal from
+		Xoshiro256StarStar randomEngine;
+	};
+
+	// the body of the pool threads, which run WorkerLoop() once per search
+	void PoolLoop(size_t index) {
+		size_t lastSearchNumber = 0;
+		while (true) {
+			{
+				unique_lock<mutex> lock{ this->poolMutex };
+				this->searchStarted.wait(lock, [this, lastSearchNumber]() {
+					return this->isStopping || this->searchNumber != lastSearchNumber;
+				});
+				if (this->isStopping)return;
+				lastSearchNumber = this->searchNumber;
+			}
+			this->WorkerLoop(index);
+			{
+				lock_guard<mutex> lock{ this->poolMutex };
+				if (--this->numOfRunningThreads > 0)continue;
+			}
+			this->searchFinished.notify_all();
+		}
+	}
+
+	void WorkerLoop(size_t index) {
+		auto &worker = this->workers[index];
+		Task task;
+
+		while (this->numOfPendingTasks.load() > 0) {
+			if (this->PopTask(worker, task) || this->StealTask(index, task)) {
+				this->Search(worker, task.depth, task.weight, task.price, task.choice);
+				// the last task wakes the idle workers to return
+				if (this->numOfPendingTasks.fetch_sub(1) == 1)this->NotifyIdleWorkers(true);
+			}
+			else {
+				this->WaitForTask();
+			}
+		}
+		this->numOfExpandedNodes.fetch_add(worker.numOfExpandedNodes);
+	}
+
+	/*
+		An idle worker announces itself before it checks for queued tasks,
+		and PushTask() counts the task before it checks for idle workers,
+		so (both being sequentially consistent) either the worker sees the
+		task or the pusher sees the worker and notifies it under the mutex,
+		which it holds from the check until it sleeps.
+	*/
+	void WaitForTask() {
+		unique_lock<mutex> lock{ this->poolMutex };
+		this->numOfIdleWorkers.fetch_add(1);
+		this->taskQueued.wait(lock, [this]() {
+			return this->numOfQueuedTasks.load() > 0 || this->numOfPendingTasks.load() == 0;
+		});
+		this->numOfIdleWorkers.fetch_sub(1);
+	}
+
+	void NotifyIdleWorkers(bool isAll) {
+		if (this->numOfIdleWorkers.load() == 0)return;
+		lock_guard<mutex> lock{ this->poolMutex };
+		if (isAll)this->taskQueued.notify_all();
+		else this->taskQueued.notify_one();
+	}
+
+	bool PopTask(Worker &worker, Task &task) {
+		lock_guard<mutex> lock{ worker.tasksMutex };
+		if (worker.tasks.empty())return false;
+		task = worker.tasks.back();
+		worker.tasks.pop_back();
+		this->numOfQueuedTasks.fetch_sub(1);
+		return true;
+	}
+
+	bool StealTask(size_t thief, Task &task) {
+		auto start = (size_t)UniformBelow(this->workers[thief].randomEngine, this->numOfThreads);
+		for (size_t i = 0; i < this->numOfThreads; ++i) {
+			auto victim = (start + i) % this->numOfThreads;
+			if (victim == thief)continue;
+			auto &worker = this->workers[victim];
+			lock_guard<mutex> lock{ worker.tasksMutex };
+			if (worker.tasks.empty())continue;
+			task = worker.tasks.front();
+			worker.tasks.pop_front();
+			this->numOfQueuedTasks.fetch_sub(1);
+			return true;
+		}
+		return false;
+	}
+
+	bool ShouldSplit(Worker &worker, size_t depth) {
+		if (this->numOfThreads == 1 || depth + minSplitSize > this->weights.size())return false;
+		lock_guard<mutex> lock{ worker.tasksMutex };
+		return worker.tasks.size() < maxQueuedTasks;
+	}
+
+	void PushTask(Worker &worker, const Task &task) {
+		// counted before it is visible, so the pending count never drops to zero early
+		this->numOfPendingTasks.fetch_add(1);
+		{
+			lock_guard<mutex> lock{ worker.tasksMutex };
+			worker.tasks.push_back(task);
+			this->numOfQueuedTasks.fetch_add(1);
+		}
+		this->NotifyIdleWorkers(false);
+	}
+
+	// the same depth-first search as KnapsackSolver::BacktrackSorted(),
+	// on the worker's own copy of the decisions
+	void Search(Worker &worker, size_t depth, WeightType weight, PriceType price, ChoiceType &choice) {
+		auto numOfItems = this->weights.size();
+		while (depth < numOfItems) {
+			++worker.numOfExpandedNodes;
+
+			// the weight never exceeds maxWeight, so the subtraction cannot wrap
+			if (this->weights[depth] <= this->maxWeight - weight) {
+				auto takenPrice = price + this->prices[depth];
+				choice.set(depth);
+				this->OfferIncumbent(takenPrice, choice, depth);
+
+				if (this->ShouldSplit(worker, depth)) {
+					// hand the "skip" branch to whoever is idle, and go on with "take"
+					Task task;
+					task.depth = depth + 1;
+					task.weight = weight;
+					task.price = price;
+					task.choice = choice;
+					task.choice.reset(depth);
+					if (this->boundSolver.GetPriceUpperBound(task.depth, task.weight, task.price) > this->bestPrice.load(memory_order_relaxed))
+						this->PushTask(worker, task);
+					weight += this->weights[depth];
+					price = takenPrice;
+					++depth;
+					continue;
+				}
+
+				this->Search(worker, depth + 1, weight + this->weights[depth], takenPrice, choice);
+				choice.reset(depth);
+			}
+
+			// skip the item
+			choice.reset(depth);
+			++depth;
+			if (this->boundSolver.GetPriceUpperBound(depth, weight, price) <= this->bestPrice.load(memory_order_relaxed))return;
+		}
+	}
+
+	/*
+		Only the decisions on items [0, depth] belong to the current path, the
+		bits after it may be left over from subtrees searched before, so they
+		are cleared in the published copy.
+	*/
+	void OfferIncumbent(PriceType price, const ChoiceType &choice, size_t depth) {
+		auto current = this->bestPrice.load(memory_order_relaxed);
+		while (price > current) {
+			if (this->bestPrice.compare_exchange_weak(current, price)) {
+				auto pathMask = ~ChoiceType{} >> (maxNumOfItems - depth - 1);
+				lock_guard<mutex> lock{ this->bestChoiceMutex };
+				// a better incumbent may have been published in the meantime
+				if (price > this->bestChoicePrice) {
+					this->bestChoice = choice & pathMask;
+					this->bestChoicePrice = price;
+				}
+				return;
+			}
+		}
+	}
+
+	KnapsackType &knapsack;
+	size_t numOfThreads;
+	// only holds the sorted columns for the bound, it never solves
+	typename KnapsackType::KnapsackSolverType boundSolver;
+
+	vector<WeightType> weights;
+	vector<PriceType> prices;
+	WeightType maxWeight{ 0 };
+
+	deque<Worker> workers;
+	// the tasks not finished yet, and those of them still in a deque
+	atomic<size_t> numOfPendingTasks{ 0 };
+	atomic<size_t> numOfQueuedTasks{ 0 };
+	atomic<size_t> numOfIdleWorkers{ 0 };
+	atomic<size_t> numOfExpandedNodes{ 0 };
+
+	atomic<PriceType> bestPrice{ 0 };
+	mutex bestChoiceMutex;
+	ChoiceType bestChoice;
+	PriceType bestChoicePrice{ 0 };
+
+	// the pool, whose threads start in the constructor body once every member is built
+	mutex poolMutex;
+	condition_variable searchStarted;
+	condition_variable searchFinished;
+	condition_variable taskQueued;
+	size_t searchNumber{ 0 };
+	size_t numOfRunningThreads{ 0 };
+	bool isStopping{ false };
+	vector<thread> poolThreads;
+};
+
+#endif
@@ -1,10 +1,16 @@
 #include "Knapsack.hpp"
+#include "ParallelKnapsack.hpp"
+#include "CoreKnapsack.hpp"
+#include "CapacitySweep.hpp"
+#include "BatchKnapsack.hpp"
+#include "KnapsackPreprocess.hpp"
 
 #include <iostream>
 #include <vector>
 #include <type_traits>
 #include <iomanip>
 #include <memory>
+#include <cstdio>
 
 using namespace std;
 
@@ -13,8 +19,9 @@ using PriceType = int;
 
 // a special container which provides access counter for operator[].
 // The knapsack utility has been desgined to only use operator[] of
-// a container when running the backtrack algorithm. In other situations,
-// iterator access and at() are used instead.
+// a container when running the backtrack algorithm without sorting.
+// The other solvers copy the items into columns once and search those,
+// so only the direct backtracking is counted.
 template<typename Type>
 class CounterVector : public vector<Type> {
 public:
@@ -133,10 +140,197 @@ int main() {
 	cout << "\n";
 
 	cout << "Solving with sorting (with branch pruning)\n";
-	knapsack.GetItems().ResetCounter();
 	auto sortedResult = move(solver.SortedSolve());
 	ShowItem(sortedResult);
-	cout << "Item access counter: " << knapsack.GetItems().ReadCounter() << "\n";
+	cout << "Expanded nodes: " << solver.GetNumOfExpandedNodes() << "\n";
+
+	cout << "\n";
+
+	cout << "Solving with best-first branch and bound\n";
+	auto bestFirstResult = move(solver.BestFirstSolve());
+	ShowItem(bestFirstResult);
+	cout << "Expanded nodes: " << solver.GetNumOfExpandedNodes() << "\n";
+
+	cout << "\n";
+
+	cout << "Search statistics of best-first branch and bound\n";
+	KnapsackSolver<WeightType, PriceType, ContainerType, SearchStatistics> statisticsSolver{ knapsack };
+	statisticsSolver.BestFirstSolve();
+	cout << statisticsSolver.GetStatistics().ToJSON() << "\n";
+
+	cout << "\n";
+
+	cout << "Solving with a budget of 5ms and 4 nodes\n";
+	auto anytimeResult = solver.AnytimeSolve(chrono::milliseconds(5), 4);
+	ShowItem(anytimeResult.items);
+	cout << "Upper bound: $" << anytimeResult.upperBound << ", gap: " << anytimeResult.gap * 100 << "%\n";
+	cout << "Expanded nodes: " << solver.GetNumOfExpandedNodes() << "\n";
+
+	cout << "\n";
+
+	cout << "Solving by dynamic programming over the capacity\n";
+	auto dpResult = move(solver.DPSolve());
+	ShowItem(dpResult);
+
+	cout << "\n";
+
+	cout << "Solving by dynamic programming over the total price\n";
+	auto profitDPResult = move(solver.ProfitDPSolve());
+	ShowItem(profitDPResult);
+
+	cout << "\n";
+
+	cout << "Solving with capacities the DP table cannot be sized by\n";
+	{
+		using LargeItemType = Item<uint64_t, uint64_t>;
+		using LargeKnapsackType = Knapsack<uint64_t, uint64_t, vector<LargeItemType>>;
+		vector<LargeItemType> largeItems;
+		for (size_t i = 0; i < weightArray.size(); ++i) {
+			largeItems.push_back(LargeItemType{ (uint64_t)weightArray[i], (uint64_t)priceArray[i] });
+		}
+		// every item fits, so the table only needs the total weight
+		LargeKnapsackType largeKnapsack{ numeric_limits<uint64_t>::max() };
+		largeKnapsack.AssignItems(move(largeItems));
+		LargeKnapsackType::KnapsackSolverType largeSolver{ largeKnapsack };
+		auto largeResult = largeSolver.DPSolve();
+		cout << "Capacity " << largeKnapsack.GetMaxWeight() << "kg: " << largeResult.size() << " of ";
+		cout << largeKnapsack.GetItems().size() << " items, $" << largeSolver.GetBestPrice() << "\n";
+
+		// nothing fits in a negative capacity
+		knapsack.SetMaxWeight(-1);
+		auto negativeResult = solver.DPSolve();
+		cout << "Capacity -1kg: " << negativeResult.size() << " items\n";
+		knapsack.SetMaxWeight(maxWeight);
+	}
+
+	cout << "\n";
+
+	cout << "Solving by meet in the middle\n";
+	auto meetInTheMiddleResult = move(solver.MeetInTheMiddleSolve());
+	ShowItem(meetInTheMiddleResult);
+
+	cout << "\n";
+
+	cout << "Solving by dynamic programming after preprocessing\n";
+	using PreprocessorType = KnapsackPreprocessor<WeightType, PriceType, ContainerType>;
+	PreprocessorType preprocessor{ knapsack };
+	auto preprocessedResult = move(preprocessor.Solve([](PreprocessorType::ReducedSolverType &reducedSolver) {
+		return reducedSolver.DPSolve();
+	}));
+	ShowItem(preprocessedResult);
+	cout << "Removed items: " << preprocessor.GetNumOfRemovedItems() << "\n";
+	cout << "Fixed items: " << preprocessor.GetNumOfFixedItems() << "\n";
+	cout << "Reduced items: " << preprocessor.GetReducedKnapsack().GetItems().size() << "\n";
+
+	cout << "\n";
+
+	cout << "Solving the core problem around the break item\n";
+	CoreKnapsackSolver<WeightType, PriceType, ContainerType> coreSolver{ knapsack };
+	auto coreResult = move(coreSolver.Solve());
+	ShowItem(coreResult);
+	cout << "Core size: " << coreSolver.GetCoreSize() << "\n";
+	cout << "Fixed items: " << coreSolver.GetNumOfFixedItems() << "\n";
+
+	cout << "\n";
+
+	cout << "Solving with weights whose sums do not fit in the weight type\n";
+	{
+		using LargeItemType = Item<uint32_t, uint32_t>;
+		using LargeKnapsackType = Knapsack<uint32_t, uint32_t, vector<LargeItemType>>;
+		const vector<LargeItemType> largeItems{
+			{ 33413484u, 133u }, { 2400994374u, 915u }, { 772917988u, 41u },
+			{ 2944131825u, 640u }, { 3400978942u, 226u }
+		};
+		const uint32_t largeMaxWeight = 4064402021u;
+		// taking all but the third item would be 1955, but it weighs 9552436613
+		const uint64_t optimalPrice = 1089;
+		auto checkResult = [largeMaxWeight, optimalPrice](const char *name, const vector<LargeItemType> &result) {
+			uint64_t totalWeight = 0, totalPrice = 0;
+			for (const auto &item : result) {
+				totalWeight += item.weight;
+				totalPrice += item.price;
+			}
+			cout << name << ": $" << totalPrice << ", " << totalWeight << "kg.\n";
+			if (totalWeight > largeMaxWeight || totalPrice != optimalPrice) {
+				throw runtime_error{ string{ name } + " found a wrong solution" };
+			}
+		};
+
+		LargeKnapsackType largeKnapsack{ largeMaxWeight };
+		largeKnapsack.AssignItems(vector<LargeItemType>{ largeItems });
+		LargeKnapsackType::KnapsackSolverType largeSolver{ largeKnapsack };
+		checkResult("Branch and bound", largeSolver.SortedSolve());
+		checkResult("Best-first", largeSolver.BestFirstSolve());
+		checkResult("Default", largeSolver.Solve());
+
+		LargeKnapsackType coreKnapsack{ largeMaxWeight };
+		coreKnapsack.AssignItems(vector<LargeItemType>{ largeItems });
+		CoreKnapsackSolver<uint32_t, uint32_t, vector<LargeItemType>> largeCoreSolver{ coreKnapsack };
+		checkResult("Core", largeCoreSolver.Solve());
+
+		ParallelKnapsackSolver<uint32_t, uint32_t, vector<LargeItemType>> largeParallelSolver{ coreKnapsack };
+		checkResult("Parallel", largeParallelSolver.Solve());
+
+		// U1 of the heavy item is far below zero, which must not wrap around
+		LargeKnapsackType boundKnapsack{ 1 };
+		boundKnapsack.AssignItems(vector<LargeItemType>{ { 1u, 10u }, { 1000u, 1u } });
+		LargeKnapsackType::KnapsackSolverType boundSolver{ boundKnapsack };
+		auto boundResult = boundSolver.AnytimeSolve(chrono::seconds(1), 0);
+		cout << "Unsigned bound: $" << boundResult.upperBound << ", gap: " << boundResult.gap * 100 << "%\n";
+		if (boundResult.upperBound != 10 || !boundResult.isOptimal)
+			throw runtime_error{ "the bound of unsigned prices wrapped around" };
+
+		// stopped after one node, the bound should still be above the optimum
+		auto limitedResult = largeSolver.AnytimeSolve(chrono::seconds(1), 1);
+		cout << "After one node: $" << limitedResult.price << ", bound: $" << limitedResult.upperBound;
+		cout << ", gap: " << limitedResult.gap * 100 << "%\n";
+		if (limitedResult.upperBound < optimalPrice || limitedResult.price > optimalPrice
+			|| limitedResult.gap < 0.0 || limitedResult.gap > 1.0)
+			throw runtime_error{ "the bound of a stopped search is wrong" };
+	}
+
+	cout << "\n";
+
+	cout << "Optimal price for every capacity\n";
+	KnapsackCapacitySweep<WeightType, PriceType, ContainerType> sweep{ knapsack };
+	for (WeightType capacity = 0; capacity <= maxWeight; capacity += 10) {
+		cout << capacity << "kg: $" << sweep.GetOptimalPrice(capacity) << "\n";
+	}
+	sweep.AddItem(Item<WeightType, PriceType>{ 5, 15 });
+	cout << "After adding a 5kg item of $15\n";
+	ShowItem(sweep.GetOptimalChoice(maxWeight));
+
+	cout << "\n";
+
+	cout << "Solving with parallel branch and bound\n";
+	ParallelKnapsackSolver<WeightType, PriceType, ContainerType> parallelSolver{ knapsack };
+	auto parallelResult = move(parallelSolver.Solve());
+	ShowItem(parallelResult);
+	cout << "Threads: " << parallelSolver.GetNumOfThreads() << "\n";
+	cout << "Expanded nodes: " << parallelSolver.GetNumOfExpandedNodes() << "\n";
+
+	cout << "\n";
+
+	cout << "Solving a file of instances in a batch\n";
+	{
+		KnapsackInstanceWriter<WeightType, PriceType> writer{ "instances.bin" };
+		writer.Write(knapsack);
+		for (WeightType capacity = 10; capacity < maxWeight; capacity += 10) {
+			writer.Write(capacity, weightArray.data(), priceArray.data(), weightArray.size());
+		}
+	}
+	BatchKnapsackSolver<WeightType, PriceType> batchSolver;
+	batchSolver.SolveFile("instances.bin", "results.bin");
+	{
+		KnapsackInstanceFile<WeightType, PriceType> instances{ "instances.bin" };
+		KnapsackResultFile<WeightType, PriceType> results{ "results.bin", instances };
+		for (size_t i = 0; i < results.GetNumOfResults(); ++i) {
+			auto result = results.GetResult(i);
+			cout << instances.GetInstance(i).capacity << "kg: $" << result.price << ", " << result.weight << "kg.\n";
+		}
+	}
+	remove("instances.bin");
+	remove("results.bin");
 
 	system("pause");
 	return 0;